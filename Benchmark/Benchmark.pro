@@ -0,0 +1,54 @@
+# This specifies the exe name
+TARGET=Benchmark
+# where to put the .o files
+OBJECTS_DIR=obj
+# this is a headless console app so we don't want any of the Qt libs
+CONFIG-=qt
+# on a mac we don't create a .app bundle file ( for ease of multiplatform use)
+CONFIG-=app_bundle
+CONFIG+=console c++11
+# Auto include all .cpp files in the project src directory (can specifiy individually if required)
+SOURCES+= $$PWD/src/*.cpp
+# same for the .h files
+HEADERS+= $$PWD/include/*.h
+# and add the include dir into the search path for Qt and make
+INCLUDEPATH +=./include
+# where our exe is going to live (root of project)
+DESTDIR=./
+OTHER_FILES+= README.md
+# basic compiler flags (not all appropriate for all platforms)
+QMAKE_CXXFLAGS+= -msse -msse2 -msse3
+macx:QMAKE_CXXFLAGS+= -arch x86_64
+# now if we are under unix and not on a Mac (i.e. linux)
+linux-*{
+		QMAKE_CXXFLAGS +=  -march=native
+		DEFINES += LINUX
+}
+DEPENDPATH+=include
+# if we are on a mac define DARWIN
+macx:DEFINES += DARWIN
+# the simulation code shared with the demos
+include(../ParticleCore/UseParticleCore.pri)
+# the OpenCL variant needs a runtime which not every node has so it is opt in
+# build with qmake CONFIG+=opencl to add it
+opencl{
+	DEFINES+=USE_OPENCL
+	INCLUDEPATH+=../OpenCLUpdate/include
+	SOURCES+=../OpenCLUpdate/src/OpenCL.cpp \
+					 ../OpenCLUpdate/src/ParticleKernel.cpp \
+					 ../OpenCLUpdate/src/KernelTuner.cpp \
+					 ../OpenCLUpdate/src/SplitKernel.cpp
+	macx:LIBS+= -framework OpenCL
+	linux-*:LIBS+= -lOpenCL
+}
+# the GL variants need EGL and a GL 4.3 / 4.4 driver (Mesa's llvmpipe will do) so they are opt in too
+# build with qmake CONFIG+=egl to add them
+egl{
+	DEFINES+=USE_EGL
+	INCLUDEPATH+=../DDD3UseTheGPU/include
+	SOURCES+=../DDD3UseTheGPU/src/FeedbackSystem.cpp \
+					 ../DDD3UseTheGPU/src/ComputeSystem.cpp \
+					 ../DDD3UseTheGPU/src/BufferRing.cpp \
+					 ../DDD3UseTheGPU/src/ShaderBuild.cpp
+	linux-*:LIBS+= -lEGL -lGL
+}
@@ -0,0 +1,14 @@
+#ifndef EGLCONTEXT_H__
+#define EGLCONTEXT_H__
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file EGLContext.h
+/// @brief the headless GL context shared by the GPU variants built with CONFIG+=egl
+//----------------------------------------------------------------------------------------------------------------------
+
+/// @brief make a GL core context with no window or surface and leave it current, this is done once and kept for the
+/// rest of the run. The newest version the driver gives (4.6 down to 3.3) is used, each variant checks the context
+/// has what it needs. A one pixel framebuffer is left bound in place of the window's
+void makeContext();
+
+#endif
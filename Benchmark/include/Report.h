@@ -0,0 +1,43 @@
+#ifndef REPORT_H__
+#define REPORT_H__
+#include <cstddef>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Report.h
+/// @brief the timings for one variant at one particle count and the CSV / JSON writers for a set of them
+//----------------------------------------------------------------------------------------------------------------------
+struct Result
+{
+  /// @brief the variant (demo directory) name
+  std::string m_variant;
+  /// @brief how many particles were simulated
+  size_t m_numParticles;
+  /// @brief time taken to create the particles (the Emitter ctor) in nanoseconds
+  double m_initNs;
+  /// @brief the time for each timed frame in nanoseconds
+  std::vector<double> m_frameNs;
+  /// @brief Variant::checksum() after the last frame, 0 if the variant doesn't have one
+  uint64_t m_checksum;
+  /// @brief set if the run could not be done, for example the allocation failed
+  std::string m_error;
+
+  /// @brief mean frame time in nanoseconds
+  double meanNs() const;
+  /// @brief the frame time at percentile _p (0-100) in nanoseconds using nearest rank
+  double percentileNs(double _p) const;
+  /// @brief mean time per particle in nanoseconds
+  double nsPerParticle() const;
+  /// @brief particles updated per second using the mean frame time
+  double particlesPerSecond() const;
+};
+
+/// @brief write all the results as CSV with a header row
+void writeCSV(std::ostream &_out, const std::vector<Result> &_results);
+/// @brief write all the results as a JSON document
+void writeJSON(std::ostream &_out, const std::vector<Result> &_results);
+
+#endif
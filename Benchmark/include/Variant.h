@@ -0,0 +1,42 @@
+#ifndef VARIANT_H__
+#define VARIANT_H__
+#include <cstddef>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Variant.h
+/// @brief each of the demo directories has its own Emitter, this wraps the update loop of one of them so it can be
+/// driven without a window. The loops are the same as the Emitter::update() in each demo with the logging and
+/// GL calls removed, the GPU variants write into a plain host array where the demo writes to the mapped VBO.
+//----------------------------------------------------------------------------------------------------------------------
+class Variant
+{
+  public :
+    virtual ~Variant(){;}
+    /// @brief the name used on the command line and in the reports, this is the demo directory name
+    virtual std::string name() const =0;
+    /// @brief allocate and fill the particles, this is the same work as the Emitter ctor
+    /// @param _numParticles the number of particles to create
+    virtual void init(size_t _numParticles)=0;
+    /// @brief run one frame of the update loop, the same work as Emitter::update()
+    virtual void update()=0;
+    /// @brief free the particles so the next run starts from a clean heap
+    virtual void release()=0;
+    /// @brief a hash of the last frame written, only the variants that write positions out (the GPU ones) have
+    /// one so 0 means not available. Two builds or thread counts that should agree can be compared with this
+    virtual uint64_t checksum() const {return 0;}
+};
+
+/// @brief 64 bit FNV-1a over a block of memory, what every Variant::checksum() is built on so equal frames give
+/// equal checksums whichever variant made them
+uint64_t fnv1a(const void *_data, size_t _bytes);
+/// @brief the names of all the variants built into this binary in the order they are run
+std::vector<std::string> variantNames();
+/// @brief create a variant by name
+/// @returns an empty pointer if the name is not known (or not built in e.g. OpenCL)
+std::unique_ptr<Variant> createVariant(const std::string &_name);
+
+#endif
@@ -0,0 +1,67 @@
+#ifdef USE_EGL
+#include "Variant.h"
+#include "ComputeSystem.h"
+#include "EGLContext.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the DDD3UseTheGPU compute mode, one dispatch per frame on the storage buffer. The frame waits for the GPU
+/// (glFinish) so the time is the update rather than just queueing it. The particles start from the deterministic
+/// CPU ones and respawn from a hash so the checksum only depends on the seed and the GL implementation. The shader
+/// is loaded from the DDD3UseTheGPU directory so both use the same source.
+//----------------------------------------------------------------------------------------------------------------------
+class DDD3UseTheGPUCompute : public Variant
+{
+  public :
+    DDD3UseTheGPUCompute() : m_compute(0)
+    {
+      const char *shader=getenv("BENCHMARK_COMPUTE_SHADER");
+      m_shaderPath = shader ? shader : "../DDD3UseTheGPU/shaders/ComputeUpdate.glsl";
+    }
+    ~DDD3UseTheGPUCompute(){release();}
+    std::string name() const {return "DDD3UseTheGPUCompute";}
+    void init(size_t _numParticles)
+    {
+      makeContext();
+      if(!ComputeSystem::isSupported())
+      {
+        std::cerr<<"Error: the GL context can't run compute shaders\n";
+        exit(EXIT_FAILURE);
+      }
+      // the CPU particles are only needed to fill the buffer
+      sim::StreamingSystem particles(sim::Vec3(0,0,0),_numParticles,0.01f,true,true);
+      m_compute = new ComputeSystem(particles,m_shaderPath,static_cast<uint32_t>(sim::RandomStream::s_defaultSeed));
+      glFinish();
+    }
+    void update()
+    {
+      m_compute->update(sim::Vec3(1,1,1));
+      glFinish();
+    }
+    void release()
+    {
+      delete m_compute;
+      m_compute=0;
+    }
+    /// @brief a hash of the bytes of the particle buffer, read back from the GPU
+    uint64_t checksum() const
+    {
+      if(m_compute==0)
+        return 0;
+      std::vector<sim::GPUParticle> particles(m_compute->size());
+      m_compute->read(&particles[0]);
+      return fnv1a(particles.data(),particles.size()*sizeof(sim::GPUParticle));
+    }
+  private :
+    std::string m_shaderPath;
+    ComputeSystem *m_compute;
+};
+
+Variant *createDDD3UseTheGPUCompute()
+{
+  return new DDD3UseTheGPUCompute;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifdef USE_EGL
+#include "EGLContext.h"
+#define GL_GLEXT_PROTOTYPES 1
+#include <GL/glcorearb.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstdlib>
+#include <iostream>
+
+void makeContext()
+{
+  static bool made=false;
+  if(made)
+    return;
+  // the surfaceless platform is tried first so it works on a node with no display at all
+  EGLDisplay display=EGL_NO_DISPLAY;
+  PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay=
+    reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  if(getPlatformDisplay)
+    display=getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,0);
+#endif
+  if(display==EGL_NO_DISPLAY)
+    display=eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if(display==EGL_NO_DISPLAY || !eglInitialize(display,0,0))
+  {
+    std::cerr<<"Error: unable to initialise EGL\n";
+    exit(EXIT_FAILURE);
+  }
+  // the default surface type is window which the surfaceless platform has none of
+  EGLint configAttribs[]={EGL_SURFACE_TYPE,EGL_PBUFFER_BIT,EGL_RENDERABLE_TYPE,EGL_OPENGL_BIT,EGL_NONE};
+  EGLConfig config;
+  EGLint numConfigs=0;
+  eglChooseConfig(display,configAttribs,&config,1,&numConfigs);
+  eglBindAPI(EGL_OPENGL_API);
+  // a driver can hand back exactly the version asked for, so ask for the newest first
+  const EGLint versions[][2]={{4,6},{4,5},{4,4},{4,3},{3,3}};
+  EGLContext context=EGL_NO_CONTEXT;
+  for(size_t i=0; i<sizeof(versions)/sizeof(versions[0]) && numConfigs>0 && context==EGL_NO_CONTEXT; ++i)
+  {
+    EGLint contextAttribs[]={EGL_CONTEXT_MAJOR_VERSION,versions[i][0],EGL_CONTEXT_MINOR_VERSION,versions[i][1],
+                             EGL_CONTEXT_OPENGL_PROFILE_MASK,EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,EGL_NONE};
+    context=eglCreateContext(display,config,EGL_NO_CONTEXT,contextAttribs);
+  }
+  // nothing is drawn to the screen so no surface is needed (EGL_KHR_surfaceless_context)
+  if(context==EGL_NO_CONTEXT || !eglMakeCurrent(display,EGL_NO_SURFACE,EGL_NO_SURFACE,context))
+  {
+    std::cerr<<"Error: unable to create a GL 3.3 or later core context\n";
+    exit(EXIT_FAILURE);
+  }
+  // with no surface there is no default framebuffer and draws fail even with the rasterizer off (transform
+  // feedback), so give them a one pixel one
+  GLuint framebuffer;
+  GLuint colour;
+  glGenFramebuffers(1,&framebuffer);
+  glGenRenderbuffers(1,&colour);
+  glBindRenderbuffer(GL_RENDERBUFFER,colour);
+  glRenderbufferStorage(GL_RENDERBUFFER,GL_RGBA8,1,1);
+  glBindFramebuffer(GL_FRAMEBUFFER,framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER,GL_COLOR_ATTACHMENT0,GL_RENDERBUFFER,colour);
+  std::cerr<<"GL variants using "<<glGetString(GL_VERSION)<<" on "<<glGetString(GL_RENDERER)<<"\n";
+  made=true;
+}
+
+#endif
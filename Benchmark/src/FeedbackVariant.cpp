@@ -0,0 +1,61 @@
+#ifdef USE_EGL
+#include "Variant.h"
+#include "FeedbackSystem.h"
+#include "EGLContext.h"
+#include <cstdlib>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the DDD3UseTheGPU transform feedback mode, one pass per frame from one buffer into the other. Only needs
+/// GL 3.3 so this is the GPU update most drivers can run. The frame waits for the GPU (glFinish) like the compute
+/// variant, starts from the same deterministic CPU particles and uses the same respawn hash, so the two give the
+/// same checksum on the same GL implementation.
+//----------------------------------------------------------------------------------------------------------------------
+class DDD3UseTheGPUFeedback : public Variant
+{
+  public :
+    DDD3UseTheGPUFeedback() : m_feedback(0)
+    {
+      const char *shader=getenv("BENCHMARK_FEEDBACK_SHADER");
+      m_shaderPath = shader ? shader : "../DDD3UseTheGPU/shaders/FeedbackUpdateVertex.glsl";
+    }
+    ~DDD3UseTheGPUFeedback(){release();}
+    std::string name() const {return "DDD3UseTheGPUFeedback";}
+    void init(size_t _numParticles)
+    {
+      makeContext();
+      // the CPU particles are only needed to fill the buffers
+      sim::StreamingSystem particles(sim::Vec3(0,0,0),_numParticles,0.01f,true,true);
+      m_feedback = new FeedbackSystem(particles,m_shaderPath,static_cast<uint32_t>(sim::RandomStream::s_defaultSeed));
+      glFinish();
+    }
+    void update()
+    {
+      m_feedback->update(sim::Vec3(1,1,1));
+      glFinish();
+    }
+    void release()
+    {
+      delete m_feedback;
+      m_feedback=0;
+    }
+    /// @brief a hash of the bytes of the buffer written last, read back from the GPU
+    uint64_t checksum() const
+    {
+      if(m_feedback==0)
+        return 0;
+      std::vector<sim::GPUParticle> particles(m_feedback->size());
+      m_feedback->read(&particles[0]);
+      return fnv1a(particles.data(),particles.size()*sizeof(sim::GPUParticle));
+    }
+  private :
+    std::string m_shaderPath;
+    FeedbackSystem *m_feedback;
+};
+
+Variant *createDDD3UseTheGPUFeedback()
+{
+  return new DDD3UseTheGPUFeedback;
+}
+
+#endif
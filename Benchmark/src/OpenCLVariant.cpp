@@ -0,0 +1,192 @@
+#ifdef USE_OPENCL
+#include "Variant.h"
+#include "OpenCL.h"
+#include "ParticleKernel.h"
+#include "KernelTuner.h"
+#include "SplitKernel.h"
+#include <sim/CLHostSystem.h>
+#include <cstdlib>
+#include <iostream>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the OpenCLUpdate emitter, the particles stay on the device and the kernel does the positions, life and
+/// respawn, only the positions are read back each frame. The kernel is loaded from the OpenCLUpdate directory and
+/// run through the same ParticleKernel so both use the same source and pipeline. Like the Emitter there are two
+/// position buffers, one being read back while the next kernel runs, so the frame time is the pipelined rate.
+/// Each device layout is its own variant, they should all give the same checksum. The launch comes from the
+/// KernelTuner results next to the kernel (timed the first time a device is seen), OPENCL_TUNE=off runs the defaults.
+//----------------------------------------------------------------------------------------------------------------------
+class OpenCLUpdate : public Variant
+{
+  public :
+    /// @param _name the variant name
+    /// @param _layout the device layout and kernel to run
+    OpenCLUpdate(const std::string &_name, ParticleKernel::Layout _layout) :
+      m_name(_name), m_layout(_layout), m_cl(0), m_system(0), m_kernel(0), m_last(0)
+    {
+      const char *kernel=getenv("BENCHMARK_CL_KERNEL");
+      m_kernelPath = kernel ? kernel : "../OpenCLUpdate/kernel/updateparticle.cl";
+    }
+    ~OpenCLUpdate(){release();}
+    std::string name() const {return m_name;}
+    void init(size_t _numParticles)
+    {
+      m_cl = new OpenCL(m_kernelPath);
+      m_system = new sim::CLHostSystem(sim::Vec3(0,0,0),_numParticles);
+      m_kernel = new ParticleKernel(m_cl,m_system,m_layout);
+      KernelTuner tuner(m_cl,m_kernelPath+".tune");
+      tuner.apply(m_kernel);
+      std::cerr<<m_name<<" work group "<<m_kernel->localSize()<<" with "<<m_kernel->perItem()<<" per work item\n";
+      for(int i=0; i<ParticleKernel::s_buffers; ++i)
+        m_glparticles[i].resize(_numParticles);
+      m_last=0;
+    }
+    void update()
+    {
+      m_last=m_kernel->slot();
+      m_kernel->update(sim::Vec3(1,1,1),&m_glparticles[m_last][0]);
+    }
+    void release()
+    {
+      if(m_cl==0)
+        return;
+      delete m_kernel;
+      delete m_system;
+      delete m_cl;
+      m_cl=0;
+      m_system=0;
+      m_kernel=0;
+      for(int i=0; i<ParticleKernel::s_buffers; ++i)
+        std::vector<sim::GLParticle>().swap(m_glparticles[i]);
+    }
+    /// @brief a hash of the positions read back, the respawns only depend on the seed, particle and frame
+    /// so this is the same from run to run on one device
+    uint64_t checksum() const
+    {
+      if(m_kernel==0)
+        return 0;
+      // the last frame is still in flight until this
+      m_kernel->finish();
+      const std::vector<sim::GLParticle> &positions=m_glparticles[m_last];
+      return fnv1a(positions.data(),positions.size()*sizeof(sim::GLParticle));
+    }
+  private :
+    std::string m_name;
+    ParticleKernel::Layout m_layout;
+    std::string m_kernelPath;
+    OpenCL *m_cl;
+    sim::CLHostSystem *m_system;
+    ParticleKernel *m_kernel;
+    std::vector<sim::GLParticle> m_glparticles[ParticleKernel::s_buffers];
+    /// @brief the buffer the last update read into
+    int m_last;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the OpenCLUpdate emitter split across the devices from --cl-devices / OPENCL_DEVICES by a SplitKernel,
+/// balanced from each device's frame times. With fewer than two devices listed it runs on the --cl-device one, so
+/// it is the same as OpenCLUpdate plus the balancing. The layout is the fastest the tuner found on the first device,
+/// the checksum matches the other OpenCL variants.
+//----------------------------------------------------------------------------------------------------------------------
+class OpenCLSplit : public Variant
+{
+  public :
+    OpenCLSplit() : m_system(0), m_split(0), m_last(0)
+    {
+      const char *kernel=getenv("BENCHMARK_CL_KERNEL");
+      m_kernelPath = kernel ? kernel : "../OpenCLUpdate/kernel/updateparticle.cl";
+    }
+    ~OpenCLSplit(){release();}
+    std::string name() const {return "OpenCLUpdateSplit";}
+    void init(size_t _numParticles)
+    {
+      std::vector<std::string> devices=OpenCL::splitDevices();
+      if(devices.empty())
+        devices.push_back("");
+      std::vector<KernelTuner *> tuners;
+      for(size_t i=0; i<devices.size(); ++i)
+      {
+        m_cls.push_back(new OpenCL(m_kernelPath,false,devices[i]));
+        tuners.push_back(new KernelTuner(m_cls[i],m_kernelPath+".tune"));
+      }
+      ParticleKernel::Layout layout=tuners[0]->fastest();
+      std::vector<double> speeds;
+      for(size_t i=0; i<tuners.size(); ++i)
+      {
+        double ns=tuners[i]->launch(layout).m_nsPerParticle;
+        speeds.push_back(ns > 0.0 ? 1.0/ns : 0.0);
+      }
+      m_system = new sim::CLHostSystem(sim::Vec3(0,0,0),_numParticles);
+      m_split = new SplitKernel(m_cls,m_system,layout,speeds);
+      for(size_t i=0; i<tuners.size(); ++i)
+      {
+        tuners[i]->apply(m_split->kernel(i));
+        delete tuners[i];
+      }
+      std::cerr<<name()<<" "<<ParticleKernel::layoutName(layout)<<" on "<<m_cls.size()<<" devices\n";
+      for(int i=0; i<ParticleKernel::s_buffers; ++i)
+        m_glparticles[i].resize(_numParticles);
+      m_last=0;
+    }
+    void update()
+    {
+      m_last=m_split->slot();
+      m_split->update(sim::Vec3(1,1,1),&m_glparticles[m_last][0]);
+    }
+    void release()
+    {
+      if(m_split==0)
+        return;
+      std::cerr<<name()<<" split moved "<<m_split->moves()<<" times, ended with";
+      for(size_t i=0; i<m_split->numDevices(); ++i)
+        std::cerr<<" "<<m_split->kernel(i)->count();
+      std::cerr<<" particles\n";
+      delete m_split;
+      delete m_system;
+      for(size_t i=0; i<m_cls.size(); ++i)
+        delete m_cls[i];
+      m_cls.clear();
+      m_split=0;
+      m_system=0;
+      for(int i=0; i<ParticleKernel::s_buffers; ++i)
+        std::vector<sim::GLParticle>().swap(m_glparticles[i]);
+    }
+    /// @brief the same hash as OpenCLUpdate
+    uint64_t checksum() const
+    {
+      if(m_split==0)
+        return 0;
+      m_split->finish();
+      const std::vector<sim::GLParticle> &positions=m_glparticles[m_last];
+      return fnv1a(positions.data(),positions.size()*sizeof(sim::GLParticle));
+    }
+  private :
+    std::string m_kernelPath;
+    std::vector<OpenCL *> m_cls;
+    sim::CLHostSystem *m_system;
+    SplitKernel *m_split;
+    std::vector<sim::GLParticle> m_glparticles[ParticleKernel::s_buffers];
+    int m_last;
+};
+
+Variant *createOpenCLUpdate()
+{
+  return new OpenCLUpdate("OpenCLUpdate",ParticleKernel::AOS);
+}
+
+Variant *createOpenCLUpdateSoA4()
+{
+  return new OpenCLUpdate("OpenCLUpdateSoA4",ParticleKernel::SOA4);
+}
+
+Variant *createOpenCLUpdateSoA8()
+{
+  return new OpenCLUpdate("OpenCLUpdateSoA8",ParticleKernel::SOA8);
+}
+
+Variant *createOpenCLUpdateSplit()
+{
+  return new OpenCLSplit();
+}
+
+#endif
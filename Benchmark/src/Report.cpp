@@ -0,0 +1,120 @@
+#include "Report.h"
+#include "Variant.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+double Result::meanNs() const
+{
+  if(m_frameNs.empty())
+    return 0.0;
+  return std::accumulate(m_frameNs.begin(),m_frameNs.end(),0.0)/m_frameNs.size();
+}
+
+double Result::percentileNs(double _p) const
+{
+  if(m_frameNs.empty())
+    return 0.0;
+  std::vector<double> sorted(m_frameNs);
+  std::sort(sorted.begin(),sorted.end());
+  // nearest rank, so p100 is the max and p0 the min
+  size_t rank=static_cast<size_t>(std::ceil(_p/100.0*sorted.size()));
+  if(rank>0)
+    --rank;
+  return sorted[std::min(rank,sorted.size()-1)];
+}
+
+double Result::nsPerParticle() const
+{
+  return m_numParticles ? meanNs()/m_numParticles : 0.0;
+}
+
+double Result::particlesPerSecond() const
+{
+  double mean=meanNs();
+  return mean>0.0 ? m_numParticles/(mean*1e-9) : 0.0;
+}
+
+static const double s_nsToMs=1e-6;
+
+/// @brief the checksum as 16 hex digits, or empty if there isn't one
+static std::string checksumString(uint64_t _checksum)
+{
+  if(_checksum==0)
+    return std::string();
+  std::ostringstream out;
+  out<<std::hex<<std::setw(16)<<std::setfill('0')<<_checksum;
+  return out.str();
+}
+
+void writeCSV(std::ostream &_out, const std::vector<Result> &_results)
+{
+  _out<<"variant,particles,frames,init_ms,mean_ms,ns_per_particle,particles_per_sec,p50_ms,p90_ms,p99_ms,min_ms,max_ms,checksum,error\n";
+  for(size_t i=0; i<_results.size(); ++i)
+  {
+    const Result &r=_results[i];
+    _out<<r.m_variant<<','<<r.m_numParticles<<','<<r.m_frameNs.size()<<','
+        <<r.m_initNs*s_nsToMs<<','<<r.meanNs()*s_nsToMs<<','<<r.nsPerParticle()<<','<<r.particlesPerSecond()<<','
+        <<r.percentileNs(50)*s_nsToMs<<','<<r.percentileNs(90)*s_nsToMs<<','<<r.percentileNs(99)*s_nsToMs<<','
+        <<r.percentileNs(0)*s_nsToMs<<','<<r.percentileNs(100)*s_nsToMs<<','<<checksumString(r.m_checksum)<<','<<r.m_error<<'\n';
+  }
+}
+
+/// @brief escape the few characters that can turn up in an error message
+static std::string jsonString(const std::string &_s)
+{
+  std::string out("\"");
+  for(size_t i=0; i<_s.size(); ++i)
+  {
+    switch(_s[i])
+    {
+      case '"' : out+="\\\""; break;
+      case '\\' : out+="\\\\"; break;
+      case '\n' : out+="\\n"; break;
+      default : out+=_s[i]; break;
+    }
+  }
+  return out+"\"";
+}
+
+void writeJSON(std::ostream &_out, const std::vector<Result> &_results)
+{
+  _out<<"{\n  \"results\" : [\n";
+  for(size_t i=0; i<_results.size(); ++i)
+  {
+    const Result &r=_results[i];
+    _out<<"    {\n"
+        <<"      \"variant\" : "<<jsonString(r.m_variant)<<",\n"
+        <<"      \"particles\" : "<<r.m_numParticles<<",\n"
+        <<"      \"frames\" : "<<r.m_frameNs.size()<<",\n"
+        <<"      \"init_ms\" : "<<r.m_initNs*s_nsToMs<<",\n"
+        <<"      \"mean_ms\" : "<<r.meanNs()*s_nsToMs<<",\n"
+        <<"      \"ns_per_particle\" : "<<r.nsPerParticle()<<",\n"
+        <<"      \"particles_per_sec\" : "<<r.particlesPerSecond()<<",\n"
+        <<"      \"frame_ms\" : { \"p50\" : "<<r.percentileNs(50)*s_nsToMs
+                               <<", \"p90\" : "<<r.percentileNs(90)*s_nsToMs
+                               <<", \"p99\" : "<<r.percentileNs(99)*s_nsToMs
+                               <<", \"min\" : "<<r.percentileNs(0)*s_nsToMs
+                               <<", \"max\" : "<<r.percentileNs(100)*s_nsToMs<<" }";
+    if(r.m_checksum)
+      _out<<",\n      \"checksum\" : \""<<checksumString(r.m_checksum)<<"\"";
+    if(!r.m_error.empty())
+      _out<<",\n      \"error\" : "<<jsonString(r.m_error);
+    _out<<"\n    }"<<(i+1<_results.size() ? "," : "")<<"\n";
+  }
+  _out<<"  ]\n}\n";
+}
+
+uint64_t fnv1a(const void *_data, size_t _bytes)
+{
+  uint64_t hash=14695981039346656037ULL;
+  const unsigned char *bytes=static_cast<const unsigned char *>(_data);
+  for(size_t i=0; i<_bytes; ++i)
+  {
+    hash^=bytes[i];
+    hash*=1099511628211ULL;
+  }
+  return hash;
+}
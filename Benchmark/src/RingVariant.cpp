@@ -0,0 +1,195 @@
+#ifdef USE_EGL
+#include "Variant.h"
+#include "BufferRing.h"
+#include "EGLContext.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <sim/StreamingSystem.h>
+
+/// @brief make the buffer the stand in draw copies a region into
+static GLuint makeFrameBuffer(size_t _bytes)
+{
+  GLuint id;
+  glGenBuffers(1,&id);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,id);
+  glBufferData(GL_COPY_WRITE_BUFFER,static_cast<GLsizeiptr>(_bytes),0,GL_STREAM_COPY);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+  return id;
+}
+
+/// @brief the stand in for the demo's draw, the GPU reads the region last written (into _frame) and it is fenced
+static void drawRegion(BufferRing *_ring, GLuint _frame, size_t _regionBytes)
+{
+  GLsizeiptr bytes=static_cast<GLsizeiptr>(_regionBytes);
+  glBindBuffer(GL_COPY_READ_BUFFER,_ring->getID());
+  glBindBuffer(GL_COPY_WRITE_BUFFER,_frame);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER,GL_COPY_WRITE_BUFFER,_ring->drawRegion()*bytes,0,bytes);
+  glBindBuffer(GL_COPY_READ_BUFFER,0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER,0);
+  _ring->fenceDraw();
+}
+
+/// @brief read back what the last stand in draw saw
+static void readFrame(GLuint _frame, void *o_data, size_t _bytes)
+{
+  glBindBuffer(GL_COPY_READ_BUFFER,_frame);
+  glGetBufferSubData(GL_COPY_READ_BUFFER,0,static_cast<GLsizeiptr>(_bytes),o_data);
+  glBindBuffer(GL_COPY_READ_BUFFER,0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the DDD3UseTheGPU update streaming into its persistent mapped BufferRing. The demo's draw is stood in for
+/// by a GPU copy of the region just written into a plain buffer, which reads the region the same way and is fenced
+/// the same way, so the ring goes through its full write / read / fence cycle with no window. The frame doesn't
+/// wait for the GPU, only beginWrite() does, so a climbing stall count means the ring is too short. The particles
+/// are the deterministic ones so the checksum (of the copy, read back) matches DDD3UseTheGPUDeterministic.
+//----------------------------------------------------------------------------------------------------------------------
+class DDD3UseTheGPURing : public Variant
+{
+  public :
+    DDD3UseTheGPURing() : m_system(0), m_ring(0), m_frame(0), m_numParticles(0){;}
+    ~DDD3UseTheGPURing(){release();}
+    std::string name() const {return "DDD3UseTheGPURing";}
+    void init(size_t _numParticles)
+    {
+      makeContext();
+      if(!BufferRing::isSupported())
+      {
+        std::cerr<<"Error: the GL context can't make persistent mapped buffers\n";
+        exit(EXIT_FAILURE);
+      }
+      m_numParticles=_numParticles;
+      m_system = new sim::StreamingSystem(sim::Vec3(0,0,0),_numParticles,0.01f,true,true);
+      m_ring = new BufferRing(_numParticles*sizeof(sim::GLParticle));
+      if(!m_ring->isValid())
+      {
+        std::cerr<<"Error: unable to map the buffer ring\n";
+        exit(EXIT_FAILURE);
+      }
+      m_system->writePositions(static_cast<float *>(m_ring->beginWrite()),3);
+      m_ring->endWrite();
+      m_frame=makeFrameBuffer(_numParticles*sizeof(sim::GLParticle));
+      glFinish();
+    }
+    void update()
+    {
+      m_system->stream(static_cast<float *>(m_ring->beginWrite()));
+      m_ring->endWrite();
+      drawRegion(m_ring,m_frame,m_numParticles*sizeof(sim::GLParticle));
+    }
+    void release()
+    {
+      if(m_ring==0)
+        return;
+      std::cerr<<name()<<" waited on the GPU "<<m_ring->numStalls()<<" times\n";
+      glDeleteBuffers(1,&m_frame);
+      delete m_ring;
+      delete m_system;
+      m_frame=0;
+      m_ring=0;
+      m_system=0;
+    }
+    /// @brief a hash of the positions the GPU read from the ring last frame
+    uint64_t checksum() const
+    {
+      if(m_ring==0)
+        return 0;
+      std::vector<sim::GLParticle> positions(m_numParticles);
+      readFrame(m_frame,&positions[0],positions.size()*sizeof(sim::GLParticle));
+      return fnv1a(positions.data(),positions.size()*sizeof(sim::GLParticle));
+    }
+  private :
+    sim::StreamingSystem *m_system;
+    BufferRing *m_ring;
+    /// @brief where the stand in draw copies the region to
+    GLuint m_frame;
+    size_t m_numParticles;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the DDD3UseTheGPU analytic mode, the update only writes the respawns into a ring of spawn record copies
+/// (each copy also gets the respawns written to the others since it was last written). The draw is stood in for as
+/// in DDD3UseTheGPURing. The checksum is of the records the GPU saw last frame, they should be the same as the CPU
+/// particles' own (writeSpawns()) and an error goes to stderr if any aren't.
+//----------------------------------------------------------------------------------------------------------------------
+class DDD3UseTheGPUAnalytic : public Variant
+{
+  public :
+    DDD3UseTheGPUAnalytic() : m_system(0), m_spawns(0), m_frame(0), m_numParticles(0){;}
+    ~DDD3UseTheGPUAnalytic(){release();}
+    std::string name() const {return "DDD3UseTheGPUAnalytic";}
+    void init(size_t _numParticles)
+    {
+      makeContext();
+      if(!BufferRing::isSupported())
+      {
+        std::cerr<<"Error: the GL context can't make persistent mapped buffers\n";
+        exit(EXIT_FAILURE);
+      }
+      m_numParticles=_numParticles;
+      m_system = new sim::StreamingSystem(sim::Vec3(0,0,0),_numParticles,0.01f,true,true);
+      m_spawns = new BufferRing(_numParticles*sizeof(sim::GLSpawn));
+      if(!m_spawns->isValid())
+      {
+        std::cerr<<"Error: unable to map the spawn ring\n";
+        exit(EXIT_FAILURE);
+      }
+      for(unsigned int i=0; i<m_spawns->numRegions(); ++i)
+      {
+        m_system->writeSpawns(static_cast<sim::GLSpawn *>(m_spawns->beginWrite()));
+        m_spawns->endWrite();
+      }
+      m_frame=makeFrameBuffer(_numParticles*sizeof(sim::GLSpawn));
+      glFinish();
+    }
+    void update()
+    {
+      m_system->advance(static_cast<sim::GLSpawn *>(m_spawns->beginWrite()),m_spawns->numRegions());
+      m_spawns->endWrite();
+      drawRegion(m_spawns,m_frame,m_numParticles*sizeof(sim::GLSpawn));
+    }
+    void release()
+    {
+      if(m_spawns==0)
+        return;
+      std::cerr<<name()<<" waited on the GPU "<<m_spawns->numStalls()<<" times\n";
+      glDeleteBuffers(1,&m_frame);
+      delete m_spawns;
+      delete m_system;
+      m_frame=0;
+      m_spawns=0;
+      m_system=0;
+    }
+    /// @brief a hash of the spawn records the GPU read last frame
+    uint64_t checksum() const
+    {
+      if(m_spawns==0)
+        return 0;
+      std::vector<sim::GLSpawn> spawns(m_numParticles);
+      std::vector<sim::GLSpawn> expected(m_numParticles);
+      readFrame(m_frame,&spawns[0],spawns.size()*sizeof(sim::GLSpawn));
+      m_system->writeSpawns(&expected[0]);
+      uint64_t hash=fnv1a(spawns.data(),spawns.size()*sizeof(sim::GLSpawn));
+      if(hash!=fnv1a(expected.data(),expected.size()*sizeof(sim::GLSpawn)))
+        std::cerr<<"Error: "<<name()<<" spawn records on the GPU differ from the particles\n";
+      return hash;
+    }
+  private :
+    sim::StreamingSystem *m_system;
+    BufferRing *m_spawns;
+    GLuint m_frame;
+    size_t m_numParticles;
+};
+
+Variant *createDDD3UseTheGPURing()
+{
+  return new DDD3UseTheGPURing;
+}
+
+Variant *createDDD3UseTheGPUAnalytic()
+{
+  return new DDD3UseTheGPUAnalytic;
+}
+
+#endif
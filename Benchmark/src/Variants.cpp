@@ -0,0 +1,159 @@
+#include "Variant.h"
+#include <sim/Emitter.h>
+#include <sim/ObjectSystem.h>
+#include <sim/StreamingSystem.h>
+#include <sim/Vec3System.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief each demo's simulation now lives in ParticleCore so the variants just drive those with the same settings
+/// the demos use (emitter at the origin, wind of 1,1,1)
+//----------------------------------------------------------------------------------------------------------------------
+
+#ifdef USE_OPENCL
+  Variant *createOpenCLUpdate();
+  Variant *createOpenCLUpdateSoA4();
+  Variant *createOpenCLUpdateSoA8();
+  Variant *createOpenCLUpdateSplit();
+#endif
+#ifdef USE_EGL
+  Variant *createDDD3UseTheGPUFeedback();
+  Variant *createDDD3UseTheGPUCompute();
+  Variant *createDDD3UseTheGPURing();
+  Variant *createDDD3UseTheGPUAnalytic();
+#endif
+
+/// @brief the systems that update in place with no output all look the same
+template <typename System>
+class SystemVariant : public Variant
+{
+  public :
+    SystemVariant(const std::string &_name) : m_name(_name), m_system(0){;}
+    ~SystemVariant(){release();}
+    std::string name() const {return m_name;}
+    void init(size_t _numParticles){m_system=new System(sim::Vec3(0,0,0),_numParticles);}
+    void update(){m_system->update();}
+    void release(){delete m_system; m_system=0;}
+  private :
+    std::string m_name;
+    System *m_system;
+};
+
+/// @brief DDD3UseTheGPU / DD3UseTheGPU2 write into the VBO, here that is a host array of the same layout
+class GPUVariant : public Variant
+{
+  public :
+    /// @param _name the demo directory name
+    /// @param _step the life increment per frame
+    /// @param _stride the number of floats per particle in the vertex buffer
+    /// @param _parallel if the loop is split across the ThreadPool as in DDD3UseTheGPU
+    /// @param _deterministic use the per particle random streams so the output doesn't depend on the thread count
+    GPUVariant(const std::string &_name, float _step, size_t _stride, bool _parallel, bool _deterministic=false) :
+      m_name(_name), m_step(_step), m_stride(_stride), m_parallel(_parallel), m_deterministic(_deterministic),
+      m_system(0){;}
+    ~GPUVariant(){release();}
+    std::string name() const {return m_name;}
+    void init(size_t _numParticles)
+    {
+      m_system=new sim::StreamingSystem(sim::Vec3(0,0,0),_numParticles,m_step,m_parallel,m_deterministic);
+      m_glBuffer.assign(_numParticles*m_stride,0.0f);
+      m_system->writePositions(&m_glBuffer[0],m_stride);
+    }
+    void update()
+    {
+      // DDD3UseTheGPU streams packed positions straight into the VBO, DD3UseTheGPU2 has a wider vertex
+      if(m_stride==3)
+        m_system->stream(&m_glBuffer[0]);
+      else
+        m_system->update(&m_glBuffer[0],m_stride);
+    }
+    void release()
+    {
+      delete m_system;
+      m_system=0;
+      std::vector<float>().swap(m_glBuffer);
+    }
+    /// @brief a hash of the bytes of the vertex buffer
+    uint64_t checksum() const
+    {
+      return fnv1a(m_glBuffer.data(),m_glBuffer.size()*sizeof(float));
+    }
+  private :
+    std::string m_name;
+    float m_step;
+    size_t m_stride;
+    bool m_parallel;
+    bool m_deterministic;
+    sim::StreamingSystem *m_system;
+    std::vector<float> m_glBuffer;
+};
+
+std::vector<std::string> variantNames()
+{
+  std::vector<std::string> names;
+  names.push_back("TypicalOO");
+  names.push_back("DDD1");
+  names.push_back("DDD2");
+  names.push_back("DDD3");
+  names.push_back("DDD3AoSoA8");
+  names.push_back("DDD3AoSoA16");
+  names.push_back("DDD3UseTheGPU");
+  names.push_back("DDD3UseTheGPUDeterministic");
+  names.push_back("DD3UseTheGPU2");
+#ifdef USE_EGL
+  names.push_back("DDD3UseTheGPUFeedback");
+  names.push_back("DDD3UseTheGPUCompute");
+  names.push_back("DDD3UseTheGPURing");
+  names.push_back("DDD3UseTheGPUAnalytic");
+#endif
+#ifdef USE_OPENCL
+  names.push_back("OpenCLUpdate");
+  names.push_back("OpenCLUpdateSoA4");
+  names.push_back("OpenCLUpdateSoA8");
+  names.push_back("OpenCLUpdateSplit");
+#endif
+  return names;
+}
+
+std::unique_ptr<Variant> createVariant(const std::string &_name)
+{
+  Variant *v=0;
+  if(_name=="TypicalOO")
+    v=new SystemVariant<sim::ObjectSystem>(_name);
+  else if(_name=="DDD1")
+    v=new SystemVariant<sim::Vec3System>(_name);
+  else if(_name=="DDD2")
+    v=new SystemVariant<sim::Emitter<sim::AoSLayout> >(_name);
+  else if(_name=="DDD3")
+    v=new SystemVariant<sim::Emitter<sim::SoALayout> >(_name);
+  else if(_name=="DDD3AoSoA8")
+    v=new SystemVariant<sim::Emitter<sim::AoSoALayout<8> > >(_name);
+  else if(_name=="DDD3AoSoA16")
+    v=new SystemVariant<sim::Emitter<sim::AoSoALayout<16> > >(_name);
+  else if(_name=="DDD3UseTheGPU")
+    v=new GPUVariant(_name,0.01f,3,true);
+  else if(_name=="DDD3UseTheGPUDeterministic")
+    v=new GPUVariant(_name,0.01f,3,true,true);
+  else if(_name=="DD3UseTheGPU2")
+    v=new GPUVariant(_name,0.05f,6,false);
+#ifdef USE_EGL
+  else if(_name=="DDD3UseTheGPUFeedback")
+    v=createDDD3UseTheGPUFeedback();
+  else if(_name=="DDD3UseTheGPUCompute")
+    v=createDDD3UseTheGPUCompute();
+  else if(_name=="DDD3UseTheGPURing")
+    v=createDDD3UseTheGPURing();
+  else if(_name=="DDD3UseTheGPUAnalytic")
+    v=createDDD3UseTheGPUAnalytic();
+#endif
+#ifdef USE_OPENCL
+  else if(_name=="OpenCLUpdate")
+    v=createOpenCLUpdate();
+  else if(_name=="OpenCLUpdateSoA4")
+    v=createOpenCLUpdateSoA4();
+  else if(_name=="OpenCLUpdateSoA8")
+    v=createOpenCLUpdateSoA8();
+  else if(_name=="OpenCLUpdateSplit")
+    v=createOpenCLUpdateSplit();
+#endif
+  return std::unique_ptr<Variant>(v);
+}
@@ -0,0 +1,203 @@
+/****************************************************************************
+headless benchmark for the emitter update loops of all the demos, no window
+or GL context is needed so it can be run on the build farm each night
+****************************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <sim/Random.h>
+#include <sim/Simd.h>
+#include "Report.h"
+#include "Variant.h"
+#ifdef USE_OPENCL
+  #include "OpenCL.h"
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+/// @brief the default sweep from 10k to 50M particles
+static const size_t s_defaultCounts[]={10000,50000,100000,500000,1000000,5000000,10000000,50000000};
+
+static void usage(const char *_exe)
+{
+  std::cerr<<"usage : "<<_exe<<" [options]\n"
+           <<"  --variants a,b,c   variants to run (default all, see --list)\n"
+           <<"  --counts n,n,n     particle counts to run (default 10k to 50M)\n"
+           <<"  --max n            drop any default count above n\n"
+           <<"  --frames n         timed frames per run (default 50)\n"
+           <<"  --warmup n         untimed frames before timing (default 5)\n"
+           <<"  --format csv|json  output format (default csv)\n"
+           <<"  --output file      write the report to file rather than stdout\n"
+           <<"  --list             list the variants built in and exit\n"
+#ifdef USE_OPENCL
+           <<"  --cl-device spec   OpenCL device: gpu, cpu, platform:device or a vendor / name\n"
+           <<"                     (default OPENCL_DEVICE or a GPU then a CPU device)\n"
+           <<"  --cl-devices spec  devices for OpenCLUpdateSplit: all or a list of the above (e.g. gpu,cpu)\n"
+#endif
+           ;
+}
+
+static std::vector<std::string> split(const std::string &_s)
+{
+  std::vector<std::string> parts;
+  std::stringstream stream(_s);
+  std::string part;
+  while(std::getline(stream,part,','))
+  {
+    if(!part.empty())
+      parts.push_back(part);
+  }
+  return parts;
+}
+
+static double elapsedNs(Clock::time_point _start)
+{
+  return std::chrono::duration<double,std::nano>(Clock::now()-_start).count();
+}
+
+static Result run(const std::string &_name, size_t _numParticles, int _warmup, int _frames)
+{
+  Result result;
+  result.m_variant=_name;
+  result.m_numParticles=_numParticles;
+  result.m_initNs=0.0;
+  result.m_checksum=0;
+  std::unique_ptr<Variant> variant=createVariant(_name);
+  // the same random sequence for every run so the respawn pattern matches
+  sim::Random::instance()->setSeed(12345);
+  try
+  {
+    Clock::time_point start=Clock::now();
+    variant->init(_numParticles);
+    result.m_initNs=elapsedNs(start);
+    for(int i=0; i<_warmup; ++i)
+    {
+      variant->update();
+    }
+    result.m_frameNs.reserve(_frames);
+    for(int i=0; i<_frames; ++i)
+    {
+      start=Clock::now();
+      variant->update();
+      result.m_frameNs.push_back(elapsedNs(start));
+    }
+    result.m_checksum=variant->checksum();
+  }
+  catch(std::bad_alloc &)
+  {
+    result.m_error="allocation failed";
+    result.m_frameNs.clear();
+  }
+  variant->release();
+  return result;
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<std::string> variants=variantNames();
+  std::vector<size_t> counts(s_defaultCounts,s_defaultCounts+sizeof(s_defaultCounts)/sizeof(size_t));
+  size_t maxCount=0;
+  int frames=50;
+  int warmup=5;
+  std::string format="csv";
+  std::string output;
+
+  for(int i=1; i<argc; ++i)
+  {
+    std::string arg(argv[i]);
+    bool hasValue = i+1<argc;
+    if(arg=="--list")
+    {
+      for(size_t v=0; v<variants.size(); ++v)
+        std::cout<<variants[v]<<"\n";
+      return EXIT_SUCCESS;
+    }
+    else if(arg=="--help" || arg=="-h")
+    {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    }
+    else if(!hasValue)
+    {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    else if(arg=="--variants")
+      variants=split(argv[++i]);
+    else if(arg=="--counts")
+    {
+      std::vector<std::string> values=split(argv[++i]);
+      counts.clear();
+      for(size_t c=0; c<values.size(); ++c)
+        counts.push_back(std::strtoull(values[c].c_str(),0,10));
+    }
+    else if(arg=="--max")
+      maxCount=std::strtoull(argv[++i],0,10);
+    else if(arg=="--frames")
+      frames=std::atoi(argv[++i]);
+    else if(arg=="--warmup")
+      warmup=std::atoi(argv[++i]);
+    else if(arg=="--format")
+      format=argv[++i];
+    else if(arg=="--output")
+      output=argv[++i];
+#ifdef USE_OPENCL
+    else if(arg=="--cl-device")
+      OpenCL::setDeviceSelection(argv[++i]);
+    else if(arg=="--cl-devices")
+      OpenCL::setDeviceSplit(argv[++i]);
+#endif
+    else
+    {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if(format!="csv" && format!="json")
+  {
+    std::cerr<<"unknown format "<<format<<"\n";
+    return EXIT_FAILURE;
+  }
+  for(size_t v=0; v<variants.size(); ++v)
+  {
+    if(!createVariant(variants[v]))
+    {
+      std::cerr<<"unknown variant "<<variants[v]<<" use --list to see what is built in\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // set SIM_SIMD=scalar|sse4|avx2|avx512 to compare the kernel levels
+  std::cerr<<"using the "<<sim::simdKernels().m_name<<" update kernels\n";
+  std::vector<Result> results;
+  for(size_t v=0; v<variants.size(); ++v)
+  {
+    for(size_t c=0; c<counts.size(); ++c)
+    {
+      if(maxCount && counts[c]>maxCount)
+        continue;
+      std::cerr<<"running "<<variants[v]<<" with "<<counts[c]<<" particles\n";
+      results.push_back(run(variants[v],counts[c],warmup,frames));
+    }
+  }
+
+  std::ofstream file;
+  if(!output.empty())
+  {
+    file.open(output.c_str());
+    if(!file.is_open())
+    {
+      std::cerr<<"unable to open "<<output<<"\n";
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream &out = output.empty() ? std::cout : file;
+  if(format=="json")
+    writeJSON(out,results);
+  else
+    writeCSV(out,results);
+  return EXIT_SUCCESS;
+}
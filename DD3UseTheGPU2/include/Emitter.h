@@ -4,28 +4,9 @@
 #include <ngl/Camera.h>
 #include <ngl/Vec3.h>
 #include <ngl/VertexArrayObject.h>
+#include <sim/StreamingSystem.h>
 #pragma pack(push,1)
 
-typedef struct Particle
-{
-
-	/// @brief the curent particle position
-	//ngl::Vec3 m_pos;
-	GLfloat m_px;
-	GLfloat m_py;
-	GLfloat m_pz;
-
-	/// @brief the direction vector of the particle
-	//ngl::Vec3 m_dir;
-	GLfloat m_dx;
-	GLfloat m_dy;
-	GLfloat m_dz;
-	/// @brief the current life value of the particle
-	GLfloat m_currentLife;
-	/// @brief gravity
-	GLfloat m_gravity;
-}Particle;
-
 typedef struct GLParticle
 {
 	GLfloat px;
@@ -61,12 +42,11 @@ public :
   inline void setShaderName(const std::string &_n){m_shaderName=_n;}
   inline const std::string getShaderName()const {return m_shaderName;}
 private :
-	/// @brief the position of the emitter
-	ngl::Vec3 m_pos;
 	/// @brief the number of particles
 	int m_numParticles;
-	/// @brief the container for the particles
-	Particle *m_particles;
+	/// @brief the particles and their update, see sim::StreamingSystem
+	sim::StreamingSystem m_particles;
+	/// @brief the vertex data used to fill the VBO the first time
 	GLParticle *m_glparticles;
 	/// @brief a wind vector
 	ngl::Vec3 *m_wind;
@@ -1,37 +1,17 @@
 #include "Emitter.h"
-#include <ngl/Random.h>
 #include <ngl/Transformation.h>
 #include <ngl/ShaderLib.h>
 #include <ngl/VAOPrimitives.h>
 /// @brief ctor
 /// @param _pos the position of the emitter
 /// @param _numParticles the number of particles to create
-Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind )
+Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind ) :
+	m_particles(sim::Vec3(_pos.m_x,_pos.m_y,_pos.m_z),_numParticles,0.05f,false)
 {
 	m_wind=_wind;
-	Particle p;
-	GLParticle g;
-	ngl::Random *rand=ngl::Random::instance();
-	m_pos=_pos;
-	m_particles = new Particle[_numParticles];
-	m_glparticles = new GLParticle[_numParticles];
+	m_glparticles = new GLParticle[_numParticles]();
 	m_vao=ngl::VertexArrayObject::createVOA(GL_POINTS);
-	for (int i=0; i< _numParticles; ++i)
-	{		
-
-		g.px=p.m_px=_pos.m_x;
-		g.py=p.m_py=_pos.m_y;
-		g.pz=p.m_pz=_pos.m_z;
-		g.px=p.m_px=rand->randomNumber(5)+0.5;
-		g.py=p.m_dy=rand->randomPositiveNumber(10)+0.5;
-		g.pz=p.m_dz=rand->randomNumber(5)+0.5;
-		p.m_currentLife=0.0;
-	//	p.m_gravity=-9;//4.65;
-
-
-		m_particles[i]=p;
-		m_glparticles[i]=g;
-	}
+	m_particles.writePositions(&m_glparticles[0].px,6);
 	m_numParticles=_numParticles;
 	m_vao->bind();
 	// create the VAO and stuff data
@@ -53,41 +33,8 @@ void Emitter::update()
 {
 	m_vao->bind();
 	ngl::Real *glPtr=m_vao->getDataPointer(0);
-	unsigned int glIndex=0;
-	for(int i=0; i<m_numParticles; ++i)
-	{
-//		m_particles[i].update();
-		m_particles[i].m_currentLife+=0.05;
-		// use projectile motion equation to calculate the new position
-		// x(t)=Ix+Vxt
-		// y(t)=Iy+Vxt-1/2gt^2
-		// z(t)=Iz+Vzt
-		m_particles[i].m_px=m_pos.m_x+(m_wind->m_x*m_particles[i].m_dx*m_particles[i].m_currentLife);
-		m_particles[i].m_py= m_pos.m_y+(m_wind->m_y*m_particles[i].m_dy*m_particles[i].m_currentLife)+m_particles[i].m_gravity*(m_particles[i].m_currentLife*m_particles[i].m_currentLife);
-		m_particles[i].m_pz=m_pos.m_z+(m_wind->m_z*m_particles[i].m_dz*m_particles[i].m_currentLife);
-		glPtr[glIndex]=m_particles[i].m_px;
-		glPtr[glIndex+1]=m_particles[i].m_py;
-		glPtr[glIndex+2]=m_particles[i].m_pz;
-		// if we go below the origin re-set
-		if(m_particles[i].m_py <= m_pos.m_y-0.01)
-		{
-			m_particles[i].m_px=m_pos.m_x;
-			m_particles[i].m_pz=m_pos.m_y;
-			m_particles[i].m_px=m_pos.m_z;
-
-			m_particles[i].m_currentLife=0.0;
-			ngl::Random *rand=ngl::Random::instance();
-			m_particles[i].m_dx=rand->randomNumber(5)+0.5;
-			m_particles[i].m_dy=rand->randomPositiveNumber(10)+0.5;
-			m_particles[i].m_dz=rand->randomNumber(5)+0.5;
-			glPtr[glIndex]=m_particles[i].m_px;
-			glPtr[glIndex+1]=m_particles[i].m_py;
-			glPtr[glIndex+2]=m_particles[i].m_pz;
-
-		}
-		glIndex+=6;
-
-	}
+	m_particles.setWind(sim::Vec3(m_wind->m_x,m_wind->m_y,m_wind->m_z));
+	m_particles.update(glPtr,6);
 	m_vao->freeDataPointer();
 
 	m_vao->unbind();
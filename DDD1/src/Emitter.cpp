@@ -1,5 +1,4 @@
 #include "Emitter.h"
-#include <ngl/Random.h>
 #include <ngl/Transformation.h>
 #include <ngl/ShaderLib.h>
 #include <ngl/VAOPrimitives.h>
@@ -11,7 +10,8 @@
 /// @brief ctor
 /// @param _pos the position of the emitter
 /// @param _numParticles the number of particles to create
-Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind )
+Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind ) :
+	m_particles(sim::Vec3(_pos.m_x,_pos.m_y,_pos.m_z),_numParticles)
 {
 	ngl::Logger *log = ngl::Logger::instance();
 	log->logMessage("Starting emitter ctor\n");
@@ -24,28 +24,26 @@ Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind )
 	m_vao->setData(1*sizeof(ngl::Vec3),point.m_x);
 	m_vao->setVertexAttributePointer(0,3,GL_FLOAT,sizeof(ngl::Vec3),0);
 	m_vao->setNumIndices(1);
+	// the per particle positions for the instanced draw, attribute 1 steps once per instance rather than per vertex
+	glGenBuffers(1,&m_instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER,m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER,_numParticles*3*sizeof(GLfloat),0,GL_STREAM_DRAW);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,0,0);
+	glVertexAttribDivisor(1,1);
 	m_vao->unbind();
+	m_instanced=true;
 
 	m_wind=_wind;
-	Particle p;
-	ngl::Random *rand=ngl::Random::instance();
-	m_pos=_pos;
-
-	for (int i=0; i< _numParticles; ++i)
-	{
-		p.m_pos=_pos;
-		p.m_dir.m_x=rand->randomNumber(5)+0.5;
-		p.m_dir.m_y=rand->randomPositiveNumber(10)+0.5;
-		p.m_dir.m_z=rand->randomNumber(5)+0.5;
-		p.m_currentLife=0.0;
-		p.m_gravity=-9;//4.65;
-
-		m_particles.push_back(p);
-	}
 	m_numParticles=_numParticles;
 	log->logMessage("finished emitter ctor\n");
 
 }
+Emitter::~Emitter()
+{
+	glDeleteBuffers(1,&m_instanceVBO);
+}
+
 /// @brief a method to update each of the particles contained in the system
 void Emitter::update()
 {
@@ -54,32 +52,8 @@ void Emitter::update()
 	ngl::Logger *log = ngl::Logger::instance();
 	log->logMessage("Starting emitter update\n");
 
-	for(int i=0; i<m_numParticles; ++i)
-	{
-//		m_particles[i].update();
-		m_particles[i].m_currentLife+=0.05;
-		// use projectile motion equation to calculate the new position
-		// x(t)=Ix+Vxt
-		// y(t)=Iy+Vxt-1/2gt^2
-		// z(t)=Iz+Vzt
-		m_particles[i].m_pos.m_x=m_pos.m_x+(m_wind->m_x*m_particles[i].m_dir.m_x*m_particles[i].m_currentLife);
-		m_particles[i].m_pos.m_y= m_pos.m_y+(m_wind->m_y*m_particles[i].m_dir.m_y*m_particles[i].m_currentLife)+m_particles[i].m_gravity*(m_particles[i].m_currentLife*m_particles[i].m_currentLife);
-		m_particles[i].m_pos.m_z=m_pos.m_z+(m_wind->m_z*m_particles[i].m_dir.m_z*m_particles[i].m_currentLife);
-
-		// if we go below the origin re-set
-		if(m_particles[i].m_pos.m_y <= m_pos.m_y-0.01)
-		{
-			m_particles[i].m_pos=m_pos;
-			m_particles[i].m_currentLife=0.0;
-			ngl::Random *rand=ngl::Random::instance();
-			m_particles[i].m_dir.m_x=rand->randomNumber(5)+0.5;
-			m_particles[i].m_dir.m_y=rand->randomPositiveNumber(10)+0.5;
-			m_particles[i].m_dir.m_z=rand->randomNumber(5)+0.5;
-		}
-
-
-
-	}
+	m_particles.setWind(sim::Vec3(m_wind->m_x,m_wind->m_y,m_wind->m_z));
+	m_particles.update();
 	log->logMessage("Finished update array took %d milliseconds\n",timer.elapsed());
 
 }
@@ -92,6 +66,12 @@ void Emitter::draw()
 	timer.start();
 	ngl::Logger *log = ngl::Logger::instance();
 	log->logMessage("Starting emitter draw\n");
+	if(m_instanced)
+	{
+		drawInstanced();
+		log->logMessage("Finished instanced draw took %d milliseconds\n",timer.elapsed());
+		return;
+	}
 	m_vao->bind();
 	ngl::ShaderLib *shader=ngl::ShaderLib::instance();
 	shader->use("Point");
@@ -105,7 +85,8 @@ void Emitter::draw()
 
 	for(int i=0; i<m_numParticles; ++i)
 	{
-		pos.translate(m_particles[i].m_pos.m_x,m_particles[i].m_pos.m_y,m_particles[i].m_pos.m_z);
+		const sim::Vec3 &p=m_particles.particle(i).m_pos;
+		pos.translate(p.m_x,p.m_y,p.m_z);
 
     MVP=m_cam->getVPMatrix() *pos;
     shader->setUniform("MVP",MVP);
@@ -116,3 +97,27 @@ void Emitter::draw()
 	log->logMessage("Finished draw took %d milliseconds\n",timer.elapsed());
 
 }
+
+void Emitter::drawInstanced()
+{
+	// invalidated so the map doesn't wait on last frame's draw, see Drawing in the ParticleCore README
+	glBindBuffer(GL_ARRAY_BUFFER,m_instanceVBO);
+	GLfloat *data=static_cast<GLfloat *>(glMapBufferRange(GL_ARRAY_BUFFER,0,m_numParticles*3*sizeof(GLfloat),
+																												 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if(data==0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER,0);
+		return;
+	}
+	m_particles.writePositions(data,3);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+
+	ngl::ShaderLib *shader=ngl::ShaderLib::instance();
+	shader->use("PointInstanced");
+	// the translation is in the instance data so this is the same for every particle and set once
+	shader->setRegisteredUniform("MVP",m_cam->getVPMatrix());
+	m_vao->bind();
+	glDrawArraysInstanced(GL_POINTS,0,1,m_numParticles);
+	m_vao->unbind();
+}
@@ -106,6 +106,19 @@ void NGLScene::initialize()
   // and make it active ready to load values
   (*shader)["Point"]->use();
   shader->autoRegisterUniforms("Point");
+  // the same point drawn once per particle with the position from an instance buffer, see Emitter::drawInstanced
+  shader->createShaderProgram("PointInstanced");
+  shader->attachShader("PointInstancedVertex",ngl::ShaderType::VERTEX);
+  shader->loadShaderSource("PointInstancedVertex","shaders/PointInstancedVertex.glsl");
+  shader->compileShader("PointInstancedVertex");
+  shader->attachShaderToProgram("PointInstanced","PointInstancedVertex");
+  shader->attachShaderToProgram("PointInstanced","PointFragment");
+  // attribute 0 is the point, 1 the per instance particle position
+  shader->bindAttribute("PointInstanced",0,"inVert");
+  shader->bindAttribute("PointInstanced",1,"inPos");
+  shader->linkProgramObject("PointInstanced");
+  shader->autoRegisterUniforms("PointInstanced");
+  (*shader)["Point"]->use();
   m_wind=new ngl::Vec3(1,1,1);
   m_emitter = new Emitter(ngl::Vec3(0,0,0),200000,m_wind);
   m_emitter->setCam(m_cam);
@@ -244,6 +257,7 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
 		case Qt::Key_O : m_wind->m_z-=0.1; break;
 
     case Qt::Key_Space : m_wind->set(1,1,1); break;
+    case Qt::Key_M : m_emitter->toggleInstanced(); break;
   default : break;
   }
   // finally update the GLWindow and re-draw
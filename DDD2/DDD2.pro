@@ -81,3 +81,6 @@ win32: {
         DEFINES+=NO_DLL
 }
 
+
+# the particle simulation shared by all the demos
+include(../ParticleCore/UseParticleCore.pri)
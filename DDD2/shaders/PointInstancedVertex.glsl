@@ -0,0 +1,14 @@
+#version 330 core
+
+
+/// @brief the vertex passed in, a single point at the origin
+in vec3 inVert;
+/// @brief the particle position, this advances once per instance
+in vec3 inPos;
+uniform mat4 MVP;
+
+void main()
+{
+  gl_Position = MVP*vec4(inVert+inPos,1.0);
+
+}
@@ -4,28 +4,7 @@
 #include <ngl/Camera.h>
 #include <ngl/Vec3.h>
 #include <ngl/VertexArrayObject.h>
-#pragma pack(push,1)
-
-typedef struct Particle
-{
-
-	/// @brief the curent particle position
-	//ngl::Vec3 m_pos;
-	GLfloat m_px;
-	GLfloat m_py;
-	GLfloat m_pz;
-
-	/// @brief the direction vector of the particle
-	//ngl::Vec3 m_dir;
-	GLfloat m_dx;
-	GLfloat m_dy;
-	GLfloat m_dz;
-	/// @brief the current life value of the particle
-	GLfloat m_currentLife;
-	/// @brief gravity
-	GLfloat m_gravity;
-}Particle;
-#pragma pack(pop)
+#include <sim/Emitter.h>
 
 class Emitter
 {
@@ -39,17 +18,20 @@ public :
 	void update();
 	/// @brief a method to draw all the particles contained in the system
 	void draw();
+	/// @brief switch between one instanced draw call and the original draw call per particle
+	inline void toggleInstanced(){m_instanced=!m_instanced;}
+	/// @brief dtor removes the instance buffer
+	~Emitter();
   inline void setCam(ngl::Camera *_cam){m_cam=_cam;}
   inline ngl::Camera * getCam()const {return m_cam;}
   inline void setShaderName(const std::string &_n){m_shaderName=_n;}
   inline const std::string getShaderName()const {return m_shaderName;}
 private :
-	/// @brief the position of the emitter
-	ngl::Vec3 m_pos;
 	/// @brief the number of particles
 	int m_numParticles;
-	/// @brief the container for the particles
-	Particle *m_particles;
+	/// @brief the particles and their update, the layout is SoA unless one of the SIM_LAYOUT defines is set in
+	/// the .pro, see sim/Layouts.h
+	sim::Emitter<sim::DefaultLayout> m_particles;
 	/// @brief a wind vector
 	ngl::Vec3 *m_wind;
   /// @brief the name of the shader to use
@@ -57,6 +39,12 @@ private :
   /// @brief a pointer to the camera used for drawing
   ngl::Camera *m_cam;
   ngl::VertexArrayObject *m_vao;
+  /// @brief draw all the particles with one instanced call, on by default, M in the demo toggles it
+  bool m_instanced;
+  /// @brief the particle positions, one per instance, refilled each draw
+  GLuint m_instanceVBO;
+  /// @brief copy the positions into m_instanceVBO and draw them all with one call
+  void drawInstanced();
 
 };
 
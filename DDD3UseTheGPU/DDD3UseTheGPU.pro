@@ -61,3 +61,6 @@ else{ # note brace must be here
 
 
 
+
+# the particle simulation shared by all the demos
+include(../ParticleCore/UseParticleCore.pri)
@@ -0,0 +1,60 @@
+#ifndef BUFFERRING_H__
+#define BUFFERRING_H__
+#include <cstddef>
+#include <vector>
+#include "GLTypes.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class BufferRing
+/// @brief a vertex buffer split into regions which stays mapped for the life of the program (GL_MAP_PERSISTENT_BIT |
+/// GL_MAP_COHERENT_BIT, GL 4.4 or ARB_buffer_storage). The update writes one region while the GPU draws from
+/// another and a fence after each draw says when the GPU has finished reading its region, so the CPU only waits if
+/// it gets a whole ring ahead. This replaces mapping and unmapping the VBO every frame which makes the driver sync
+/// with the GPU. Only uses GL so the Benchmark can run it headless.
+//----------------------------------------------------------------------------------------------------------------------
+class BufferRing
+{
+public :
+	/// @brief true if the current context can make persistent mapped buffers
+	static bool isSupported();
+	/// @brief ctor allocates and maps the buffer, needs a current context. Check isValid() before using the ring
+	/// @param _regionBytes the size of each region, one frame's worth of vertex data
+	/// @param _numRegions how many regions, 3 lets the CPU write one while the GPU reads one with one spare
+	BufferRing(size_t _regionBytes, unsigned int _numRegions=3);
+	/// @brief dtor unmaps and deletes the buffer and any fences left
+	~BufferRing();
+	/// @brief false if the buffer couldn't be mapped, the caller should delete the ring and map its VBO each frame
+	/// instead
+	inline bool isValid() const {return m_data!=0;}
+	/// @brief the buffer to bind for the vertex attributes, the regions are back to back in it
+	inline GLuint getID() const {return m_id;}
+	/// @brief wait until the GPU has finished with the next region and return where to write it
+	void *beginWrite();
+	/// @brief the region from the last beginWrite() is complete and becomes the one to draw
+	void endWrite();
+	inline unsigned int numRegions() const {return m_numRegions;}
+	/// @brief the region the next draw should read, the last one written
+	inline unsigned int drawRegion() const {return m_drawRegion;}
+	/// @brief call after the draw that reads drawRegion() so it isn't written again until the GPU is done with it
+	void fenceDraw();
+	/// @brief how many times beginWrite() had to wait for the GPU, if this climbs the GPU is the bottleneck
+	inline unsigned int numStalls() const {return m_numStalls;}
+
+private :
+	/// @brief the buffer
+	GLuint m_id;
+	/// @brief the persistent mapping of the whole buffer, 0 if the map failed
+	char *m_data;
+	size_t m_regionBytes;
+	unsigned int m_numRegions;
+	unsigned int m_writeRegion;
+	unsigned int m_drawRegion;
+	/// @brief the fence after the last draw from each region, 0 if there isn't one
+	std::vector<GLsync> m_fences;
+	unsigned int m_numStalls;
+	// owns GL objects so no copies
+	BufferRing(const BufferRing &);
+	BufferRing &operator=(const BufferRing &);
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef COMPUTESYSTEM_H__
+#define COMPUTESYSTEM_H__
+#include <string>
+#include <stdint.h>
+#include "GLTypes.h"
+#include <sim/StreamingSystem.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ComputeSystem
+/// @brief the particle update done with a GL 4.3 compute shader. The particles (sim::GPUParticle) live in one
+/// shader storage buffer and a single dispatch does the position, life, ground test and respawn for all of them in
+/// place, with the respawn directions from an integer hash in the shader. The same buffer is then the vertex
+/// source for the draw so nothing goes back to the CPU. Only uses GL so the Benchmark can run it headless.
+//----------------------------------------------------------------------------------------------------------------------
+class ComputeSystem
+{
+public :
+	/// @brief true if the current context can run compute shaders (GL 4.3 or ARB_compute_shader)
+	static bool isSupported();
+	/// @brief ctor loads and builds the compute shader and copies the particles to the GPU, needs a current context
+	/// @param _particles the particles to copy, the GPU carries on from their current direction and life
+	/// @param _shader the path of the compute shader source
+	/// @param _seed the seed for the respawn directions
+	ComputeSystem(const sim::StreamingSystem &_particles, const std::string &_shader, uint32_t _seed);
+	/// @brief dtor deletes the program, buffer and vertex array
+	~ComputeSystem();
+	/// @brief run one update on the GPU
+	/// @param _wind the wind vector to use
+	void update(const sim::Vec3 &_wind);
+	/// @brief draw the particles as points, attribute 0 is the position so this works with the same shader as the
+	/// CPU modes
+	void draw();
+	/// @brief copy the particles back, for checking and checksums only
+	void read(sim::GPUParticle *o_particles) const;
+	inline GLuint getID() const {return m_buffer;}
+	inline size_t size() const {return m_numParticles;}
+
+private :
+	/// @brief the local size in ComputeUpdate.glsl
+	static const GLuint s_groupSize=256;
+	/// @brief the smallest GL_MAX_COMPUTE_WORK_GROUP_COUNT allowed
+	static const GLuint s_maxGroups=65535;
+	size_t m_numParticles;
+	GLuint m_program;
+	/// @brief where the wind goes, the only uniform that changes, the rest are set once in the ctor
+	GLint m_windUniform;
+	/// @brief the particles, bound as shader storage for the update and as the vertex buffer for the draw
+	GLuint m_buffer;
+	GLuint m_vao;
+	// owns GL objects so no copies
+	ComputeSystem(const ComputeSystem &);
+	ComputeSystem &operator=(const ComputeSystem &);
+};
+
+#endif
@@ -4,49 +4,29 @@
 #include <ngl/Camera.h>
 #include <ngl/Vec3.h>
 #include <ngl/SimpleVAO.h>
-#pragma pack(push,1)
-
-typedef struct Particle
-{
-
-	/// @brief the curent particle position
-	//ngl::Vec3 m_pos;
-	GLfloat m_px;
-	GLfloat m_py;
-	GLfloat m_pz;
-
-	/// @brief the direction vector of the particle
-	//ngl::Vec3 m_dir;
-	GLfloat m_dx;
-	GLfloat m_dy;
-	GLfloat m_dz;
-	/// @brief the current life value of the particle
-	GLfloat m_currentLife;
-	/// @brief gravity
-	GLfloat m_gravity;
-}Particle;
-
-typedef struct GLParticle
-{
-	GLfloat px;
-	GLfloat py;
-	GLfloat pz;
-//	GLfloat dx;
-//	GLfloat dy;
-//	GLfloat dz;
-}GLParticle;
-
-
-
-#pragma pack(pop)
-
-
-
-
+#include <sim/StreamingSystem.h>
+#include "BufferRing.h"
+#include "ComputeSystem.h"
+#include "FeedbackSystem.h"
 
 class Emitter
 {
 public :
+	/// @brief how the positions get to the GPU
+	enum RenderMode
+	{
+		/// @brief the update writes every position to the vertex buffer each frame
+		STREAM_POSITIONS,
+		/// @brief the GPU keeps each particle's direction and birth frame and the vertex shader works out the
+		/// position, the update only uploads the particles that respawned
+		ANALYTIC,
+		/// @brief the update runs in a vertex shader with transform feedback and the particles stay on the GPU, see
+		/// FeedbackSystem
+		TRANSFORM_FEEDBACK,
+		/// @brief the update and respawn run in one compute shader dispatch on a storage buffer which is also the
+		/// vertex buffer, see ComputeSystem
+		COMPUTE
+	};
 
 	/// @brief ctor
 	/// @param _pos the position of the emitter
@@ -57,18 +37,34 @@ public :
 	/// @brief a method to draw all the particles contained in the system
 	void draw(const ngl::Mat4 &_rot);
 	~Emitter();
+	/// @brief switch to the next render mode, ANALYTIC needs the persistent mapped buffers so is skipped without them.
+	/// TRANSFORM_FEEDBACK only needs GL 3.3, COMPUTE needs 4.3 and is skipped without it
+	void nextRenderMode();
+	inline RenderMode getRenderMode() const {return m_mode;}
   inline void setCam(ngl::Camera *_cam){m_cam=_cam;}
   inline ngl::Camera * getCam()const {return m_cam;}
   inline void setShaderName(const std::string &_n){m_shaderName=_n;}
   inline const std::string getShaderName()const {return m_shaderName;}
 private :
-	/// @brief the position of the emitter
-	ngl::Vec3 m_pos;
 	/// @brief the number of particles
 	int m_numParticles;
-	/// @brief the container for the particles
-	Particle *m_particles;
-	GLParticle *m_glparticles;
+	/// @brief the particles and their update, see sim::StreamingSystem. Made in the ctor body so the
+	/// "Finished filling array" time includes creating them
+	sim::StreamingSystem *m_particles;
+	/// @brief the persistent mapped vertex buffer the update writes to, 0 if the context can't do GL 4.4 buffer
+	/// storage or the map failed, in which case the VBO is mapped each update as before
+	BufferRing *m_ring;
+	/// @brief the render mode in use
+	RenderMode m_mode;
+	/// @brief the GLSpawn per particle for ANALYTIC, a region per frame in flight and each update only writes the
+	/// respawns the region hasn't had yet. Made the first time the mode is used
+	BufferRing *m_spawns;
+	/// @brief the vertex array reading m_spawns
+	GLuint m_spawnVAO;
+	/// @brief the GPU copy of the particles for TRANSFORM_FEEDBACK, made again each time the mode is picked
+	FeedbackSystem *m_feedback;
+	/// @brief the GPU copy of the particles for COMPUTE, made again each time the mode is picked
+	ComputeSystem *m_compute;
 	/// @brief a wind vector
 	ngl::Vec3 *m_wind;
   /// @brief the name of the shader to use
@@ -76,6 +72,13 @@ private :
   /// @brief a pointer to the camera used for drawing
   ngl::Camera *m_cam;
   ngl::SimpleVAO *m_vao;
+	/// @brief make the spawn buffer if needed and fill it from the CPU particles
+	/// @returns false if the spawn buffer couldn't be mapped, the mode is left as it was
+	bool startAnalytic();
+	/// @brief copy the CPU particles to a new FeedbackSystem
+	void startFeedback();
+	/// @brief copy the CPU particles to a new ComputeSystem
+	void startCompute();
 
 };
 
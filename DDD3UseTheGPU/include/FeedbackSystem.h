@@ -0,0 +1,57 @@
+#ifndef FEEDBACKSYSTEM_H__
+#define FEEDBACKSYSTEM_H__
+#include <string>
+#include <stdint.h>
+#include "GLTypes.h"
+#include <sim/StreamingSystem.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class FeedbackSystem
+/// @brief the particle update done on the GPU with transform feedback (GL 3.3). The particles live in two buffer
+/// objects, each update runs the update vertex shader over one with the rasterizer off and captures the new state
+/// into the other, then they swap. Nothing comes back to the CPU and the draw reads the positions straight from
+/// the buffer written last, so the only per frame traffic is a few uniforms. Only uses GL so the Benchmark can run
+/// it headless.
+//----------------------------------------------------------------------------------------------------------------------
+class FeedbackSystem
+{
+public :
+	/// @brief one particle in the buffers, the order the update shader's outputs are captured in
+	typedef sim::GPUParticle Particle;
+	/// @brief ctor builds the update program, makes the buffers and starts them off from the CPU particles, needs a
+	/// current context
+	/// @param _particles the particles to copy, the GPU carries on from their current direction and life
+	/// @param _shader the path of the update vertex shader source
+	/// @param _seed the seed for the respawn directions
+	FeedbackSystem(const sim::StreamingSystem &_particles, const std::string &_shader, uint32_t _seed);
+	/// @brief dtor deletes the program, buffers and vertex arrays
+	~FeedbackSystem();
+	/// @brief run one update on the GPU
+	/// @param _wind the wind vector to use
+	void update(const sim::Vec3 &_wind);
+	/// @brief draw the particles as points from the buffer written last, attribute 0 is the position so this works
+	/// with the same shader as the CPU modes
+	void draw();
+	/// @brief copy the particles back from the buffer written last, for checking and checksums only
+	void read(Particle *o_particles) const;
+	inline size_t size() const {return m_numParticles;}
+
+private :
+	size_t m_numParticles;
+	/// @brief the update program, linked with the outputs captured in Particle order
+	GLuint m_program;
+	/// @brief where the wind goes, the only uniform that changes, the rest are set once in the ctor
+	GLint m_windUniform;
+	/// @brief the two copies of the particles
+	GLuint m_buffers[2];
+	/// @brief a vertex array for each buffer, the position on attribute 0 for drawing and the direction, life and
+	/// respawn count on 1 and 2 for the update
+	GLuint m_vaos[2];
+	/// @brief the buffer with the latest state, the other is written by the next update
+	unsigned int m_current;
+	// owns GL objects so no copies
+	FeedbackSystem(const FeedbackSystem &);
+	FeedbackSystem &operator=(const FeedbackSystem &);
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef GLTYPES_H__
+#define GLTYPES_H__
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file GLTypes.h
+/// @brief the GL types and prototypes for the classes here that only use GL. The demo gets them from NGL, the
+/// Benchmark builds these classes without NGL so gets the core profile header itself
+//----------------------------------------------------------------------------------------------------------------------
+#ifdef USE_EGL
+	#define GL_GLEXT_PROTOTYPES 1
+	#include <GL/glcorearb.h>
+#else
+	#include <ngl/Types.h>
+#endif
+
+#endif
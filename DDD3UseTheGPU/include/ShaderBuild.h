@@ -0,0 +1,22 @@
+#ifndef SHADERBUILD_H__
+#define SHADERBUILD_H__
+#include <string>
+#include "GLTypes.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @file ShaderBuild.h
+/// @brief building the GPU update programs without ngl::ShaderLib so the Benchmark can build them too. Both report
+/// a failure with the GL log on std::cerr and exit, as a missing update shader leaves nothing to run
+//----------------------------------------------------------------------------------------------------------------------
+
+/// @brief load and compile a shader
+/// @param _type the stage e.g. GL_COMPUTE_SHADER
+/// @param _path the source file
+/// @returns the shader, attach it then delete it once the program is linked
+GLuint loadShader(GLenum _type, const std::string &_path);
+/// @brief link a program with its shaders attached
+/// @param _program the program
+/// @param _name used in the error message
+void linkProgram(GLuint _program, const std::string &_name);
+
+#endif
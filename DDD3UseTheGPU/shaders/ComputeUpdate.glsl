@@ -0,0 +1,83 @@
+#version 430 core
+
+layout(local_size_x=256) in;
+
+/// @brief the same layout as sim::GPUParticle
+struct Particle
+{
+  float px;
+  float py;
+  float pz;
+  float dx;
+  float dy;
+  float dz;
+  float life;
+  uint respawns;
+};
+
+layout(std430, binding=0) buffer Particles
+{
+  Particle particles[];
+};
+
+/// @brief the emitter position
+uniform vec3 origin;
+uniform vec3 wind;
+uniform float gravity;
+/// @brief the life added each update
+uniform float step;
+uniform int seed;
+/// @brief the number of particles, the last group is only partly used
+uniform uint count;
+
+/// @brief the same hash as FeedbackUpdateVertex.glsl so both GPU modes respawn the same way
+uint hash(uint _x)
+{
+  _x^=_x>>16;
+  _x*=0x7feb352du;
+  _x^=_x>>15;
+  _x*=0x846ca68bu;
+  _x^=_x>>16;
+  return _x;
+}
+
+/// @brief 0-1 from the top 24 bits of a hash
+float uniformFloat(uint _h)
+{
+  return float(_h>>8)*(1.0/16777216.0);
+}
+
+void main()
+{
+  // big counts are dispatched as rows of groups, see ComputeSystem::update
+  uint i=gl_GlobalInvocationID.y*gl_NumWorkGroups.x*gl_WorkGroupSize.x+gl_GlobalInvocationID.x;
+  if(i>=count)
+    return;
+  Particle p=particles[i];
+  p.life+=step;
+  // use projectile motion equation to calculate the new position
+  // x(t)=Ix+Vxt
+  // y(t)=Iy+Vxt-1/2gt^2
+  // z(t)=Iz+Vzt
+  vec3 dir=vec3(p.dx,p.dy,p.dz);
+  vec3 pos=origin+wind*dir*p.life;
+  pos.y+=gravity*p.life*p.life;
+  // if we go below the origin re-set
+  if(pos.y <= origin.y-0.01)
+  {
+    ++p.respawns;
+    uint h=hash(uint(seed)^hash(i^hash(p.respawns)));
+    uint h1=hash(h);
+    uint h2=hash(h1);
+    // the same mapping as randomNumber / randomPositiveNumber
+    p.dx=(uniformFloat(h)*2.0-1.0)*5.0+0.5;
+    p.dy=uniformFloat(h1)*10.0+0.5;
+    p.dz=(uniformFloat(h2)*2.0-1.0)*5.0+0.5;
+    p.life=0.0;
+    pos=origin;
+  }
+  p.px=pos.x;
+  p.py=pos.y;
+  p.pz=pos.z;
+  particles[i]=p;
+}
@@ -0,0 +1,65 @@
+#version 330 core
+
+/// @brief the particle's direction in xyz and life in w, see FeedbackSystem::Particle
+in vec4 inDirLife;
+/// @brief how many times the particle has respawned, picks its next random numbers
+in uint inRespawns;
+/// @brief the emitter position
+uniform vec3 origin;
+uniform vec3 wind;
+uniform float gravity;
+/// @brief the life added each update
+uniform float step;
+uniform int seed;
+
+/// @brief captured by transform feedback into the other buffer, in the same order as FeedbackSystem::Particle
+out vec3 outPos;
+out vec4 outDirLife;
+flat out uint outRespawns;
+
+/// @brief a 32 bit integer hash (lowbias32) so each particle's numbers only depend on seed, id and respawn count
+uint hash(uint _x)
+{
+  _x^=_x>>16;
+  _x*=0x7feb352du;
+  _x^=_x>>15;
+  _x*=0x846ca68bu;
+  _x^=_x>>16;
+  return _x;
+}
+
+/// @brief 0-1 from the top 24 bits of a hash
+float uniformFloat(uint _h)
+{
+  return float(_h>>8)*(1.0/16777216.0);
+}
+
+void main()
+{
+  vec3 dir=inDirLife.xyz;
+  float life=inDirLife.w+step;
+  uint respawns=inRespawns;
+  // use projectile motion equation to calculate the new position
+  // x(t)=Ix+Vxt
+  // y(t)=Iy+Vxt-1/2gt^2
+  // z(t)=Iz+Vzt
+  vec3 pos=origin+wind*dir*life;
+  pos.y+=gravity*life*life;
+  // if we go below the origin re-set
+  if(pos.y <= origin.y-0.01)
+  {
+    ++respawns;
+    uint h=hash(uint(seed)^hash(uint(gl_VertexID)^hash(respawns)));
+    uint h1=hash(h);
+    uint h2=hash(h1);
+    // the same mapping as randomNumber / randomPositiveNumber
+    dir=vec3((uniformFloat(h)*2.0-1.0)*5.0+0.5,
+             uniformFloat(h1)*10.0+0.5,
+             (uniformFloat(h2)*2.0-1.0)*5.0+0.5);
+    life=0.0;
+    pos=origin;
+  }
+  outPos=pos;
+  outDirLife=vec4(dir,life);
+  outRespawns=respawns;
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+/// @brief the direction in xyz and the frame the particle was (re)spawned on in w, see sim::GLSpawn
+in vec4 inSpawn;
+uniform mat4 MVP;
+/// @brief the emitter position
+uniform vec3 origin;
+uniform vec3 wind;
+uniform float gravity;
+/// @brief the life added each update
+uniform float step;
+/// @brief the number of updates so far
+uniform float frame;
+
+void main()
+{
+  // the same projectile motion as the CPU update
+  // x(t)=Ix+Vxt
+  // y(t)=Iy+Vxt-1/2gt^2
+  // z(t)=Iz+Vzt
+  float life=(frame-inSpawn.w)*step;
+  vec3 pos=origin+wind*inSpawn.xyz*life;
+  pos.y+=gravity*life*life;
+  gl_Position = MVP * vec4(pos,1);
+}
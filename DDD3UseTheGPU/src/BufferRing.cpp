@@ -0,0 +1,95 @@
+#include "BufferRing.h"
+#include <cstring>
+#include <iostream>
+
+/// @brief how long to wait on a fence each time round, in nanoseconds
+static const GLuint64 s_fenceTimeout=1000000;
+
+bool BufferRing::isSupported()
+{
+	GLint major=0;
+	GLint minor=0;
+	glGetIntegerv(GL_MAJOR_VERSION,&major);
+	glGetIntegerv(GL_MINOR_VERSION,&minor);
+	if(major>4 || (major==4 && minor>=4))
+		return true;
+	GLint numExtensions=0;
+	glGetIntegerv(GL_NUM_EXTENSIONS,&numExtensions);
+	for(GLint i=0; i<numExtensions; ++i)
+	{
+		const char *name=reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS,i));
+		if(name!=0 && std::strcmp(name,"GL_ARB_buffer_storage")==0)
+			return true;
+	}
+	return false;
+}
+
+BufferRing::BufferRing(size_t _regionBytes, unsigned int _numRegions) :
+	m_regionBytes(_regionBytes), m_numRegions(_numRegions), m_writeRegion(0), m_drawRegion(0),
+	m_fences(_numRegions,static_cast<GLsync>(0)), m_numStalls(0)
+{
+	GLbitfield flags=GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	GLsizeiptr size=static_cast<GLsizeiptr>(m_regionBytes*m_numRegions);
+	glGenBuffers(1,&m_id);
+	glBindBuffer(GL_ARRAY_BUFFER,m_id);
+	// immutable storage, the mapping stays valid while the GPU reads from it
+	glBufferStorage(GL_ARRAY_BUFFER,size,0,flags);
+	m_data=static_cast<char *>(glMapBufferRange(GL_ARRAY_BUFFER,0,size,flags));
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+	if(m_data==0)
+	{
+		std::cerr<<"unable to map the "<<size<<" byte vertex buffer ring\n";
+		glDeleteBuffers(1,&m_id);
+		m_id=0;
+	}
+}
+
+BufferRing::~BufferRing()
+{
+	for(unsigned int i=0; i<m_numRegions; ++i)
+	{
+		if(m_fences[i])
+			glDeleteSync(m_fences[i]);
+	}
+	if(m_data==0)
+		return;
+	glBindBuffer(GL_ARRAY_BUFFER,m_id);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+	glDeleteBuffers(1,&m_id);
+}
+
+void *BufferRing::beginWrite()
+{
+	GLsync fence=m_fences[m_writeRegion];
+	if(fence)
+	{
+		// the first check flushes so the fence is sure to have been submitted, then wait if the GPU isn't done
+		GLenum status=glClientWaitSync(fence,GL_SYNC_FLUSH_COMMANDS_BIT,0);
+		if(status==GL_TIMEOUT_EXPIRED)
+		{
+			++m_numStalls;
+			do
+			{
+				status=glClientWaitSync(fence,0,s_fenceTimeout);
+			}while(status==GL_TIMEOUT_EXPIRED);
+		}
+		glDeleteSync(fence);
+		m_fences[m_writeRegion]=0;
+	}
+	return m_data+m_writeRegion*m_regionBytes;
+}
+
+void BufferRing::endWrite()
+{
+	m_drawRegion=m_writeRegion;
+	m_writeRegion=(m_writeRegion+1)%m_numRegions;
+}
+
+void BufferRing::fenceDraw()
+{
+	// the same region can be drawn more than once between updates, only the last draw matters
+	if(m_fences[m_drawRegion])
+		glDeleteSync(m_fences[m_drawRegion]);
+	m_fences[m_drawRegion]=glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+}
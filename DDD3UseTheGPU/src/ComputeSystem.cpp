@@ -0,0 +1,103 @@
+#include "ComputeSystem.h"
+#include "ShaderBuild.h"
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+bool ComputeSystem::isSupported()
+{
+	GLint major=0;
+	GLint minor=0;
+	glGetIntegerv(GL_MAJOR_VERSION,&major);
+	glGetIntegerv(GL_MINOR_VERSION,&minor);
+	if(major>4 || (major==4 && minor>=3))
+		return true;
+	GLint numExtensions=0;
+	glGetIntegerv(GL_NUM_EXTENSIONS,&numExtensions);
+	for(GLint i=0; i<numExtensions; ++i)
+	{
+		const char *name=reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS,i));
+		if(name!=0 && std::strcmp(name,"GL_ARB_compute_shader")==0)
+			return true;
+	}
+	return false;
+}
+
+ComputeSystem::ComputeSystem(const sim::StreamingSystem &_particles, const std::string &_shader, uint32_t _seed) :
+	m_numParticles(_particles.size())
+{
+	GLuint shader=loadShader(GL_COMPUTE_SHADER,_shader);
+	m_program=glCreateProgram();
+	glAttachShader(m_program,shader);
+	linkProgram(m_program,_shader);
+	glDeleteShader(shader);
+	// the uniforms stay with the program so only the wind is set each update
+	const sim::Vec3 &pos=_particles.position();
+	glUseProgram(m_program);
+	glUniform3f(glGetUniformLocation(m_program,"origin"),pos.m_x,pos.m_y,pos.m_z);
+	// the same gravity every particle is made with
+	glUniform1f(glGetUniformLocation(m_program,"gravity"),-9.0f);
+	glUniform1f(glGetUniformLocation(m_program,"step"),_particles.step());
+	glUniform1i(glGetUniformLocation(m_program,"seed"),static_cast<GLint>(_seed));
+	glUniform1ui(glGetUniformLocation(m_program,"count"),static_cast<GLuint>(m_numParticles));
+	glUseProgram(0);
+	m_windUniform=glGetUniformLocation(m_program,"wind");
+
+	// only here to fill the buffer, after this the particles never come back to the CPU
+	std::vector<sim::GPUParticle> particles(m_numParticles);
+	_particles.writePositions(&particles[0].m_px,sizeof(sim::GPUParticle)/sizeof(float));
+	for(size_t i=0; i<m_numParticles; ++i)
+	{
+		const sim::FlatParticle &p=_particles.particle(i);
+		particles[i].m_dx=p.m_dx;
+		particles[i].m_dy=p.m_dy;
+		particles[i].m_dz=p.m_dz;
+		particles[i].m_currentLife=p.m_currentLife;
+		particles[i].m_respawns=0;
+	}
+	glGenBuffers(1,&m_buffer);
+	glGenVertexArrays(1,&m_vao);
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER,m_buffer);
+	glBufferData(GL_ARRAY_BUFFER,m_numParticles*sizeof(sim::GPUParticle),&particles[0],GL_DYNAMIC_COPY);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(sim::GPUParticle),
+												reinterpret_cast<void *>(offsetof(sim::GPUParticle,m_px)));
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+ComputeSystem::~ComputeSystem()
+{
+	glDeleteVertexArrays(1,&m_vao);
+	glDeleteBuffers(1,&m_buffer);
+	glDeleteProgram(m_program);
+}
+
+void ComputeSystem::update(const sim::Vec3 &_wind)
+{
+	glUseProgram(m_program);
+	glUniform3f(m_windUniform,_wind.m_x,_wind.m_y,_wind.m_z);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER,0,m_buffer);
+	// only 65535 groups are guaranteed in x (16M particles) so beyond that the groups go in rows
+	GLuint numGroups=static_cast<GLuint>((m_numParticles+s_groupSize-1)/s_groupSize);
+	GLuint rows=(numGroups+s_maxGroups-1)/s_maxGroups;
+	glDispatchCompute(rows>1 ? s_maxGroups : numGroups,rows,1);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER,0,0);
+	// the writes have to be visible to the draw, the next dispatch and any read back
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void ComputeSystem::draw()
+{
+	glBindVertexArray(m_vao);
+	glDrawArrays(GL_POINTS,0,static_cast<GLsizei>(m_numParticles));
+	glBindVertexArray(0);
+}
+
+void ComputeSystem::read(sim::GPUParticle *o_particles) const
+{
+	glBindBuffer(GL_ARRAY_BUFFER,m_buffer);
+	glGetBufferSubData(GL_ARRAY_BUFFER,0,m_numParticles*sizeof(sim::GPUParticle),o_particles);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+}
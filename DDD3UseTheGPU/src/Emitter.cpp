@@ -1,10 +1,24 @@
 #include "Emitter.h"
-#include <ngl/Random.h>
 #include <ngl/Transformation.h>
 #include <ngl/ShaderLib.h>
 #include <ngl/VAOFactory.h>
 #include <ngl/Logger.h>
 #include <QElapsedTimer>
+#include <cstdlib>
+
+/// @brief set SIM_DETERMINISTIC=1 to give each particle its own random stream so the frames are the same for any
+/// SIM_THREADS, and SIM_SEED to replay a particular run
+static bool deterministic()
+{
+	const char *env=std::getenv("SIM_DETERMINISTIC");
+	return env!=0 && env[0]!='\0' && env[0]!='0';
+}
+
+static uint64_t seed()
+{
+	const char *env=std::getenv("SIM_SEED");
+	return env!=0 ? std::strtoull(env,0,10) : sim::RandomStream::s_defaultSeed;
+}
 
 /// @brief ctor
 /// @param _pos the position of the emitter
@@ -12,42 +26,54 @@
 Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind )
 {
 	m_wind=_wind;
-	Particle p;
-	GLParticle g;
-	ngl::Random *rand=ngl::Random::instance();
+	m_mode=STREAM_POSITIONS;
+	m_spawns=0;
+	m_spawnVAO=0;
+	m_feedback=0;
+	m_compute=0;
 	ngl::Logger *log = ngl::Logger::instance();
 	log->logMessage("Starting emitter ctor\n");
 	QElapsedTimer timer;
 	timer.start();
-	m_pos=_pos;
-	m_particles = new Particle[_numParticles];
-	m_glparticles = new GLParticle[_numParticles];
-  m_vao=ngl::VAOFactory::createVAO(ngl::simpleVAO,GL_POINTS);
-	#pragma omp parallel for ordered schedule(dynamic)
-	for (int i=0; i< _numParticles; ++i)
-	{		
-
-		g.px=p.m_px=m_pos.m_x;
-		g.py=p.m_py=m_pos.m_y;
-		g.pz=p.m_pz=m_pos.m_z;
-
-		p.m_dx=rand->randomNumber(5)+0.5;
-		p.m_dy=rand->randomPositiveNumber(10)+0.5;
-		p.m_dz=rand->randomNumber(5)+0.5;
-		p.m_currentLife=0.0;
-		p.m_gravity=-9;//4.65;
-
-
-		m_particles[i]=p;
-		m_glparticles[i]=g;
-	}
+	// the particles are created in parallel on the sim::ThreadPool with a random stream per thread
+	m_particles = new sim::StreamingSystem(sim::Vec3(_pos.m_x,_pos.m_y,_pos.m_z),_numParticles,0.01f,true,
+																				 deterministic(),seed());
+	if(m_particles->deterministic())
+		log->logMessage("Deterministic mode, seed %llu\n",static_cast<unsigned long long>(seed()));
 	m_numParticles=_numParticles;
+  m_vao=ngl::VAOFactory::createVAO(ngl::simpleVAO,GL_POINTS);
 	m_vao->bind();
-	// create the VAO and stuff data
-	m_vao->setData(m_numParticles*sizeof(GLParticle),m_glparticles[0].px);
-	m_vao->setVertexAttributePointer(0,3,GL_FLOAT,sizeof(GLParticle),0);
+	m_ring=0;
+	if(BufferRing::isSupported())
+	{
+		m_ring = new BufferRing(m_numParticles*sizeof(sim::GLParticle));
+		if(!m_ring->isValid())
+		{
+			delete m_ring;
+			m_ring=0;
+		}
+	}
+	if(m_ring)
+	{
+		// three frames of positions in one persistently mapped buffer, the VAO just points at it
+		m_particles->writePositions(static_cast<float *>(m_ring->beginWrite()),3);
+		m_ring->endWrite();
+		glBindBuffer(GL_ARRAY_BUFFER,m_ring->getID());
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(sim::GLParticle),0);
+		log->logMessage("Using a persistent mapped buffer ring\n");
+	}
+	else
+	{
+		// the first positions only live here until they are in the VBO, after that the update writes straight to it
+		std::vector<sim::GLParticle> positions(m_numParticles);
+		m_particles->writePositions(&positions[0].px,3);
+		// create the VAO and stuff data
+		m_vao->setData(m_numParticles*sizeof(sim::GLParticle),positions[0].px);
+		m_vao->setVertexAttributePointer(0,3,GL_FLOAT,sizeof(sim::GLParticle),0);
+	}
 // uv same as above but starts at 0 and is attrib 1 and only u,v so 2
-//m_vao->setVertexAttributePointer(1,3,GL_FLOAT,sizeof(GLParticle),3);
+//m_vao->setVertexAttributePointer(1,3,GL_FLOAT,sizeof(sim::GLParticle),3);
 m_vao->setNumIndices(m_numParticles);
 m_vao->unbind();
 log->logMessage("Finished filling array took %d milliseconds\n",timer.elapsed());
@@ -57,11 +83,91 @@ log->logMessage("Finished filling array took %d milliseconds\n",timer.elapsed())
 
 Emitter::~Emitter()
 {
-	delete [] m_glparticles;
-	delete [] m_particles;
+	delete m_particles;
+	delete m_ring;
+	delete m_spawns;
+	delete m_feedback;
+	delete m_compute;
+	if(m_spawnVAO)
+		glDeleteVertexArrays(1,&m_spawnVAO);
 	m_vao->removeVOA();
 }
 
+void Emitter::nextRenderMode()
+{
+	switch(m_mode)
+	{
+		case STREAM_POSITIONS :
+			if(m_ring && startAnalytic())
+				break;
+			// fall through - no persistent buffers so skip the analytic mode
+		case ANALYTIC :
+			ngl::Logger::instance()->logMessage("Spawn ring waited on the GPU %u times\n",m_spawns->numStalls());
+			startFeedback();
+		break;
+		case TRANSFORM_FEEDBACK :
+			if(ComputeSystem::isSupported())
+			{
+				startCompute();
+				break;
+			}
+			// fall through - no compute shaders so straight back to the CPU
+		case COMPUTE :
+			// the next update writes every position so there is nothing to carry over, the CPU particles carry on
+			// from where they were when the GPU took over
+			m_mode=STREAM_POSITIONS;
+			ngl::Logger::instance()->logMessage("Render mode stream positions\n");
+		break;
+	}
+}
+
+bool Emitter::startAnalytic()
+{
+	if(!m_spawns)
+	{
+		// a copy of the records per frame in flight as for the positions, so an update never waits for the draw
+		m_spawns = new BufferRing(m_numParticles*sizeof(sim::GLSpawn));
+		if(!m_spawns->isValid())
+		{
+			delete m_spawns;
+			m_spawns=0;
+			return false;
+		}
+		glGenVertexArrays(1,&m_spawnVAO);
+		glBindVertexArray(m_spawnVAO);
+		glBindBuffer(GL_ARRAY_BUFFER,m_spawns->getID());
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0,4,GL_FLOAT,GL_FALSE,sizeof(sim::GLSpawn),0);
+		glBindVertexArray(0);
+	}
+	// the whole array once into every copy, from then on only the respawns
+	for(unsigned int i=0; i<m_spawns->numRegions(); ++i)
+	{
+		m_particles->writeSpawns(static_cast<sim::GLSpawn *>(m_spawns->beginWrite()));
+		m_spawns->endWrite();
+	}
+	m_mode=ANALYTIC;
+	ngl::Logger::instance()->logMessage("Render mode analytic\n");
+	return true;
+}
+
+void Emitter::startFeedback()
+{
+	// start again from the CPU particles each time so the GPU picks up from whatever mode came before
+	delete m_feedback;
+	m_feedback = new FeedbackSystem(*m_particles,"shaders/FeedbackUpdateVertex.glsl",static_cast<uint32_t>(seed()));
+	m_mode=TRANSFORM_FEEDBACK;
+	ngl::Logger::instance()->logMessage("Render mode transform feedback\n");
+}
+
+void Emitter::startCompute()
+{
+	delete m_compute;
+	m_compute = new ComputeSystem(*m_particles,"shaders/ComputeUpdate.glsl",static_cast<uint32_t>(seed()));
+	m_mode=COMPUTE;
+	ngl::Logger::instance()->logMessage("Render mode compute\n");
+}
+
 /// @brief a method to update each of the particles contained in the system
 void Emitter::update()
 {
@@ -70,51 +176,39 @@ void Emitter::update()
 	ngl::Logger *log = ngl::Logger::instance();
 	log->logMessage("Starting emitter update\n");
 
-	m_vao->bind();
-	ngl::Real *glPtr=m_vao->getDataPointer(0);
-    unsigned int glIndex=0;
-    #pragma omp parallel for
-
-	for(int i=0; i<m_numParticles; ++i)
-	{
-//		m_particles[i].update();
-		m_particles[i].m_currentLife+=0.01;
-		// use projectile motion equation to calculate the new position
-		// x(t)=Ix+Vxt
-		// y(t)=Iy+Vxt-1/2gt^2
-		// z(t)=Iz+Vzt
-
-		m_particles[i].m_px=m_pos.m_x+(m_wind->m_x*m_particles[i].m_dx*m_particles[i].m_currentLife);
-		m_particles[i].m_py= m_pos.m_y+(m_wind->m_y*m_particles[i].m_dy*m_particles[i].m_currentLife)+m_particles[i].m_gravity*(m_particles[i].m_currentLife*m_particles[i].m_currentLife);
-		m_particles[i].m_pz=m_pos.m_z+(m_wind->m_z*m_particles[i].m_dz*m_particles[i].m_currentLife);
-		glPtr[glIndex]=m_particles[i].m_px;
-		glPtr[glIndex+1]=m_particles[i].m_py;
-		glPtr[glIndex+2]=m_particles[i].m_pz;
-		// if we go below the origin re-set
-		if(m_particles[i].m_py <= m_pos.m_y-0.01)
-		//if(m_particles[i].m_currentLife > 1.0)
-		{
-			m_particles[i].m_px=m_pos.m_x;
-			m_particles[i].m_pz=m_pos.m_y;
-			m_particles[i].m_px=m_pos.m_z;
-
-			m_particles[i].m_currentLife=0.0;
-			ngl::Random *rand=ngl::Random::instance();
-			m_particles[i].m_dx=rand->randomNumber(5)+0.5;
-			m_particles[i].m_dy=rand->randomPositiveNumber(10)+0.5;
-			m_particles[i].m_dz=rand->randomNumber(5)+0.5;
-			glPtr[glIndex]=m_particles[i].m_px;
-			glPtr[glIndex+1]=m_particles[i].m_py;
-			glPtr[glIndex+2]=m_particles[i].m_pz;
-
-		}
-		#pragma omp atomic
-		glIndex+=3;
-
+	m_particles->setWind(sim::Vec3(m_wind->m_x,m_wind->m_y,m_wind->m_z));
+	if(m_mode==COMPUTE)
+	{
+		// one dispatch, the CPU particles are left where they were
+		m_compute->update(sim::Vec3(m_wind->m_x,m_wind->m_y,m_wind->m_z));
+	}
+	else if(m_mode==TRANSFORM_FEEDBACK)
+	{
+		// all on the GPU, the CPU particles are left where they were
+		m_feedback->update(sim::Vec3(m_wind->m_x,m_wind->m_y,m_wind->m_z));
+	}
+	else if(m_mode==ANALYTIC)
+	{
+		// only the particles that respawned are written, everything else is already on the GPU. The copy being
+		// written was last brought up to date a ring ago so it also gets the respawns written to the others since
+		m_particles->advance(static_cast<sim::GLSpawn *>(m_spawns->beginWrite()),m_spawns->numRegions());
+		m_spawns->endWrite();
+	}
+	else if(m_ring)
+	{
+		// write the region the GPU isn't reading, no map or unmap so no sync with the driver. The positions only go
+		// to the buffer (with streaming stores) and are not kept in the particles as well
+		m_particles->stream(static_cast<float *>(m_ring->beginWrite()));
+		m_ring->endWrite();
+	}
+	else
+	{
+		m_vao->bind();
+		ngl::Real *glPtr=m_vao->getDataPointer(0);
+		m_particles->stream(glPtr);
+		m_vao->freeDataPointer();
+		m_vao->unbind();
 	}
-	m_vao->freeDataPointer();
-
-	m_vao->unbind();
 	log->logMessage("Finished update array took %d milliseconds\n",timer.elapsed());
 
 }
@@ -153,12 +247,51 @@ void Emitter::draw(const ngl::Mat4 &_rot)
 
 	}*/
 
+	if(m_mode==ANALYTIC)
+	{
+		shader->use("PointAnalytic");
+		const sim::Vec3 &pos=m_particles->position();
+		shader->setUniform("MVP",_rot*vp);
+		shader->setUniform("origin",ngl::Vec3(pos.m_x,pos.m_y,pos.m_z));
+		shader->setUniform("wind",*m_wind);
+		// the same gravity every particle is made with
+		shader->setUniform("gravity",-9.0f);
+		shader->setUniform("step",m_particles->step());
+		shader->setUniform("frame",static_cast<float>(m_particles->frame()));
+		glBindVertexArray(m_spawnVAO);
+		glDrawArrays(GL_POINTS,m_spawns->drawRegion()*m_numParticles,m_numParticles);
+		glBindVertexArray(0);
+		m_spawns->fenceDraw();
+		log->logMessage("Finished draw took %d milliseconds\n",timer.elapsed());
+		return;
+	}
+
 	shader->setUniform("MVP",_rot*vp);
 //	shader->setUniform("MV",m_cam->getViewMatrix());
 
-	m_vao->bind();
-	m_vao->draw();
-	m_vao->unbind();
+	if(m_mode==COMPUTE)
+	{
+		// the storage buffer the update wrote is the vertex buffer
+		m_compute->draw();
+	}
+	else if(m_mode==TRANSFORM_FEEDBACK)
+	{
+		// straight from the buffer the last update captured
+		m_feedback->draw();
+	}
+	else
+	{
+		m_vao->bind();
+		if(m_ring)
+		{
+			// the regions are back to back so the first vertex picks the one written last
+			glDrawArrays(GL_POINTS,m_ring->drawRegion()*m_numParticles,m_numParticles);
+			m_ring->fenceDraw();
+		}
+		else
+			m_vao->draw();
+		m_vao->unbind();
+	}
 
 	log->logMessage("Finished draw took %d milliseconds\n",timer.elapsed());
 
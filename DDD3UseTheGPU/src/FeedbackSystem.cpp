@@ -0,0 +1,103 @@
+#include "FeedbackSystem.h"
+#include "ShaderBuild.h"
+#include <cstddef>
+#include <vector>
+
+/// @brief the update shader outputs in Particle order
+static const char *s_varyings[3]={"outPos","outDirLife","outRespawns"};
+
+FeedbackSystem::FeedbackSystem(const sim::StreamingSystem &_particles, const std::string &_shader, uint32_t _seed) :
+	m_numParticles(_particles.size()), m_current(0)
+{
+	// there is no fragment stage, the outputs are captured in Particle order
+	GLuint shader=loadShader(GL_VERTEX_SHADER,_shader);
+	m_program=glCreateProgram();
+	glAttachShader(m_program,shader);
+	glBindAttribLocation(m_program,1,"inDirLife");
+	glBindAttribLocation(m_program,2,"inRespawns");
+	glTransformFeedbackVaryings(m_program,3,s_varyings,GL_INTERLEAVED_ATTRIBS);
+	linkProgram(m_program,_shader);
+	glDeleteShader(shader);
+	// the uniforms stay with the program so only the wind is set each update
+	const sim::Vec3 &pos=_particles.position();
+	glUseProgram(m_program);
+	glUniform3f(glGetUniformLocation(m_program,"origin"),pos.m_x,pos.m_y,pos.m_z);
+	// the same gravity every particle is made with
+	glUniform1f(glGetUniformLocation(m_program,"gravity"),-9.0f);
+	glUniform1f(glGetUniformLocation(m_program,"step"),_particles.step());
+	glUniform1i(glGetUniformLocation(m_program,"seed"),static_cast<GLint>(_seed));
+	glUseProgram(0);
+	m_windUniform=glGetUniformLocation(m_program,"wind");
+
+	// only here to fill the buffers, after this the particles never come back to the CPU
+	std::vector<Particle> particles(m_numParticles);
+	_particles.writePositions(&particles[0].m_px,sizeof(Particle)/sizeof(float));
+	for(size_t i=0; i<m_numParticles; ++i)
+	{
+		const sim::FlatParticle &p=_particles.particle(i);
+		particles[i].m_dx=p.m_dx;
+		particles[i].m_dy=p.m_dy;
+		particles[i].m_dz=p.m_dz;
+		particles[i].m_currentLife=p.m_currentLife;
+		particles[i].m_respawns=0;
+	}
+	glGenBuffers(2,m_buffers);
+	glGenVertexArrays(2,m_vaos);
+	for(unsigned int b=0; b<2; ++b)
+	{
+		glBindVertexArray(m_vaos[b]);
+		glBindBuffer(GL_ARRAY_BUFFER,m_buffers[b]);
+		// both start the same, written and read only by the GPU from now on
+		glBufferData(GL_ARRAY_BUFFER,m_numParticles*sizeof(Particle),&particles[0],GL_DYNAMIC_COPY);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0,3,GL_FLOAT,GL_FALSE,sizeof(Particle),
+													reinterpret_cast<void *>(offsetof(Particle,m_px)));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1,4,GL_FLOAT,GL_FALSE,sizeof(Particle),
+													reinterpret_cast<void *>(offsetof(Particle,m_dx)));
+		glEnableVertexAttribArray(2);
+		glVertexAttribIPointer(2,1,GL_UNSIGNED_INT,sizeof(Particle),
+													 reinterpret_cast<void *>(offsetof(Particle,m_respawns)));
+	}
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+}
+
+FeedbackSystem::~FeedbackSystem()
+{
+	glDeleteVertexArrays(2,m_vaos);
+	glDeleteBuffers(2,m_buffers);
+	glDeleteProgram(m_program);
+}
+
+void FeedbackSystem::update(const sim::Vec3 &_wind)
+{
+	glUseProgram(m_program);
+	glUniform3f(m_windUniform,_wind.m_x,_wind.m_y,_wind.m_z);
+	unsigned int next=1-m_current;
+	// read one buffer as vertices and capture into the other, no fragments needed
+	glEnable(GL_RASTERIZER_DISCARD);
+	glBindVertexArray(m_vaos[m_current]);
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER,0,m_buffers[next]);
+	glBeginTransformFeedback(GL_POINTS);
+	glDrawArrays(GL_POINTS,0,static_cast<GLsizei>(m_numParticles));
+	glEndTransformFeedback();
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER,0,0);
+	glBindVertexArray(0);
+	glDisable(GL_RASTERIZER_DISCARD);
+	m_current=next;
+}
+
+void FeedbackSystem::draw()
+{
+	glBindVertexArray(m_vaos[m_current]);
+	glDrawArrays(GL_POINTS,0,static_cast<GLsizei>(m_numParticles));
+	glBindVertexArray(0);
+}
+
+void FeedbackSystem::read(Particle *o_particles) const
+{
+	glBindBuffer(GL_ARRAY_BUFFER,m_buffers[m_current]);
+	glGetBufferSubData(GL_ARRAY_BUFFER,0,m_numParticles*sizeof(Particle),o_particles);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+}
@@ -108,6 +108,19 @@ void NGLScene::initializeGL()
   // and make it active ready to load values
   (*shader)["Point"]->use();
   shader->autoRegisterUniforms("Point");
+  // the positions worked out in the vertex shader from each particle's direction and birth frame, see
+  // Emitter::ANALYTIC
+  shader->createShaderProgram("PointAnalytic");
+  shader->attachShader("PointAnalyticVertex",ngl::ShaderType::VERTEX);
+  shader->loadShaderSource("PointAnalyticVertex","shaders/PointAnalyticVertex.glsl");
+  shader->compileShader("PointAnalyticVertex");
+  shader->attachShaderToProgram("PointAnalytic","PointAnalyticVertex");
+  shader->attachShaderToProgram("PointAnalytic","PointFragment");
+  shader->bindAttribute("PointAnalytic",0,"inSpawn");
+  shader->linkProgramObject("PointAnalytic");
+  shader->autoRegisterUniforms("PointAnalytic");
+  // the transform feedback and compute updates build their own programs, see FeedbackSystem and ComputeSystem
+  (*shader)["Point"]->use();
 
   //shader->setShaderParam1i("Normalize",1);
 
@@ -287,6 +300,7 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
 		case Qt::Key_O : m_wind->m_z-=0.1; break;
 
     case Qt::Key_Space : m_wind->set(1,1,1); break;
+    case Qt::Key_M : m_emitter->nextRenderMode(); break;
   default : break;
   }
   // finally update the GLWindow and re-draw
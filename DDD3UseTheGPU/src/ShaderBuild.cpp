@@ -0,0 +1,46 @@
+#include "ShaderBuild.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+GLuint loadShader(GLenum _type, const std::string &_path)
+{
+	std::ifstream file(_path.c_str());
+	if(!file.is_open())
+	{
+		std::cerr<<"unable to open shader "<<_path<<"\n";
+		exit(EXIT_FAILURE);
+	}
+	std::stringstream source;
+	source<<file.rdbuf();
+	std::string text=source.str();
+	const char *src=text.c_str();
+	GLuint shader=glCreateShader(_type);
+	glShaderSource(shader,1,&src,0);
+	glCompileShader(shader);
+	GLint compiled=0;
+	glGetShaderiv(shader,GL_COMPILE_STATUS,&compiled);
+	if(!compiled)
+	{
+		char log[4096];
+		glGetShaderInfoLog(shader,sizeof(log),0,log);
+		std::cerr<<"unable to compile shader "<<_path<<"\n"<<log<<"\n";
+		exit(EXIT_FAILURE);
+	}
+	return shader;
+}
+
+void linkProgram(GLuint _program, const std::string &_name)
+{
+	glLinkProgram(_program);
+	GLint linked=0;
+	glGetProgramiv(_program,GL_LINK_STATUS,&linked);
+	if(!linked)
+	{
+		char log[4096];
+		glGetProgramInfoLog(_program,sizeof(log),0,log);
+		std::cerr<<"unable to link "<<_name<<"\n"<<log<<"\n";
+		exit(EXIT_FAILURE);
+	}
+}
@@ -0,0 +1,21 @@
+# builds the shared simulation library first and then everything that uses it
+TEMPLATE=subdirs
+SUBDIRS= ParticleCore \
+				 TypicalOO \
+				 DDD1 \
+				 DDD2 \
+				 DDD3 \
+				 DDD3UseTheGPU \
+				 DD3UseTheGPU2 \
+				 OpenCLUpdate \
+				 Benchmark
+# DD3UseTheGPU2 doesn't follow the dir/dir.pro naming
+DD3UseTheGPU2.file=DD3UseTheGPU2/DD3UseTheGPU.pro
+TypicalOO.depends=ParticleCore
+DDD1.depends=ParticleCore
+DDD2.depends=ParticleCore
+DDD3.depends=ParticleCore
+DDD3UseTheGPU.depends=ParticleCore
+DD3UseTheGPU2.depends=ParticleCore
+OpenCLUpdate.depends=ParticleCore
+Benchmark.depends=ParticleCore
@@ -5,6 +5,8 @@ OBJECTS_DIR=obj
 # core Qt Libs to use add more here if needed.
 QT+=gui opengl core
 macx:LIBS+= -framework OpenCL
+# the kernel writes the VBOs through CL/GL sharing when the driver can, see OpenCL.cpp
+DEFINES+=USE_GL_SHARING
 
 CONFIG+=c++11
 
@@ -58,3 +60,6 @@ else{ # note brace must be here
 	message("Using custom NGL location")
 	include($(NGLDIR)/UseNGL.pri)
 }
+
+# the particle simulation shared by all the demos
+include(../ParticleCore/UseParticleCore.pri)
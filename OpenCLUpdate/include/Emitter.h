@@ -4,43 +4,10 @@
 #include <ngl/Vec3.h>
 #include <ngl/VertexArrayObject.h>
 #include "OpenCL.h"
-
-#pragma pack(push,1)
-
-typedef struct Particle
-{
-
-	/// @brief the curent particle position
-	//ngl::Vec3 m_pos;
-	GLfloat m_px;
-	GLfloat m_py;
-	GLfloat m_pz;
-
-	/// @brief the direction vector of the particle
-	//ngl::Vec3 m_dir;
-	GLfloat m_dx;
-	GLfloat m_dy;
-	GLfloat m_dz;
-	/// @brief the current life value of the particle
-	GLfloat m_currentLife;
-}Particle;
-
-typedef struct GLParticle
-{
-	GLfloat px;
-	GLfloat py;
-	GLfloat pz;
-//	GLfloat dx;
-//	GLfloat dy;
-//	GLfloat dz;
-}GLParticle;
-
-
-
-#pragma pack(pop)
-
-
-
+#include "ParticleKernel.h"
+#include "KernelTuner.h"
+#include "SplitKernel.h"
+#include <sim/CLHostSystem.h>
 
 
 class Emitter
@@ -60,34 +27,51 @@ public :
   inline ngl::Camera * getCam()const {return m_cam;}
   inline void setShaderName(const std::string &_n){m_shaderName=_n;}
   inline const std::string getShaderName()const {return m_shaderName;}
-  inline void incTime(float _t){m_time+=_t;}
-  inline void decTime(float _t){m_time-=_t;}
-  inline void updatePos(float _x, float _y, float _z){
-    m_pos.m_x+=_x;
-    m_pos.m_y+=_y;
-    m_pos.m_z+=_z;
-  }
+  inline void incTime(float _t){m_particles.incTime(_t);}
+  inline void decTime(float _t){m_particles.decTime(_t);}
+  inline void updatePos(float _x, float _y, float _z){m_particles.updatePos(_x,_y,_z);}
+  /// @brief switch to the next device layout / kernel (AoS, SoA float4, SoA float8), the particles start again
+  /// from the host start state as each layout keeps its own copy on the device
+  void nextLayout();
 
 private :
-	/// @brief the position of the emitter
-	ngl::Vec3 m_pos;
+	/// @brief replace the kernel with one for a layout, the VBOs are left as they are
+	void makeKernel(ParticleKernel::Layout _layout);
+	/// @brief log the device timestamps for a frame or the upload, relative to when the first command was queued
+	void logProfile(const char *_what, const ParticleKernel::Profile &_profile);
+	/// @brief the slot the next update writes, from whichever kernel is running
+	inline int slot() const {return m_split ? m_split->slot() : m_kernel->slot();}
+	/// @brief true if the kernel writes the VBOs itself, never when split
+	inline bool isShared() const {return m_kernel && m_kernel->isShared();}
 	/// @brief the number of particles
 	size_t m_numParticles;
-	/// @brief the container for the particles
-	Particle *m_particles;
-	GLParticle *m_glparticles;
+	/// @brief the host side particles, the start state and emit direction, see sim::CLHostSystem
+	sim::CLHostSystem m_particles;
 	/// @brief a wind vector
 	ngl::Vec3 *m_wind;
   /// @brief the name of the shader to use
   std::string m_shaderName;
   /// @brief a pointer to the camera used for drawing
   ngl::Camera *m_cam;
-  ngl::VertexArrayObject *m_vao;
+  /// @brief one VAO / VBO per ParticleKernel slot, one is drawn while the device fills the other
+  ngl::VertexArrayObject *m_vao[ParticleKernel::s_buffers];
+  GLuint m_vbo[ParticleKernel::s_buffers];
+  /// @brief the mapped pointer for each VBO when the positions are read back, 0 if not mapped
+  sim::GLParticle *m_mapped[ParticleKernel::s_buffers];
+  /// @brief fence after each VBO's last draw, CL can't take a shared buffer until GL is done with it
+  GLsync m_fence[ParticleKernel::s_buffers];
+  /// @brief the VBO holding the last finished frame
+  int m_draw;
   OpenCL *m_cl;
-  cl_mem m_input;                       // device memory used for the input array
-  cl_mem m_output;                      // device memory used for the output array
-  size_t m_workgroupsize;
-  float m_time;
+  /// @brief the device particles and the kernel that updates them
+  ParticleKernel *m_kernel;
+  /// @brief the launch for each layout on this device
+  KernelTuner *m_tuner;
+  /// @brief any more devices from --cl-devices, m_cl is the first, and their launches
+  std::vector<OpenCL *> m_others;
+  std::vector<KernelTuner *> m_otherTuners;
+  /// @brief the kernels when the particles are split across the devices, m_kernel is 0 then
+  SplitKernel *m_split;
 
 };
 
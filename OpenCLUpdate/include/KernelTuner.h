@@ -0,0 +1,56 @@
+#ifndef KERNELTUNER_H__
+#define KERNELTUNER_H__
+#include <string>
+#include "OpenCL.h"
+#include "ParticleKernel.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class KernelTuner
+/// @brief picks the ParticleKernel launch for a device by timing it. The first time a device is seen every layout
+/// (AoS, SoA float4, SoA float8) is run with a range of work group sizes and particles per work item and the
+/// fastest of each is written to a text file, later runs on the same device and driver just read it back. Set
+/// OPENCL_TUNE=off to skip it and use the defaults, or OPENCL_RETUNE to time again.
+//----------------------------------------------------------------------------------------------------------------------
+class KernelTuner
+{
+public :
+	/// @brief the launch for one layout
+	struct Launch
+	{
+		/// @brief the work group size, 0 for the runtime's choice
+		size_t m_local;
+		/// @brief vectors of particles per work item
+		size_t m_perItem;
+		/// @brief the time it took, 0 if it wasn't timed
+		double m_nsPerParticle;
+	};
+	/// @brief ctor loads the results for the OpenCL device or times it if there are none
+	/// @param _cl the OpenCL context with updateparticle.cl loaded
+	/// @param _file the results file, OPENCL_TUNE_FILE overrides it
+	KernelTuner(OpenCL *_cl, const std::string &_file);
+	/// @brief the launch for a layout
+	inline const Launch &launch(ParticleKernel::Layout _layout) const {return m_launch[_layout];}
+	/// @brief the fastest layout, AOS if nothing was timed
+	ParticleKernel::Layout fastest() const;
+	/// @brief set a kernel to the launch for its layout
+	void apply(ParticleKernel *_kernel) const;
+
+private :
+	/// @brief time every layout and launch on a scratch set of particles
+	void tune();
+	/// @brief read this device's results, false if there are none
+	bool load();
+	/// @brief write this device's results keeping any other device's
+	void save() const;
+	/// @brief how many particles are timed, big enough to be memory bound but quick to run
+	static const size_t s_particles=1<<20;
+	/// @brief frames run before and during the timing of each launch
+	static const int s_warmup=2;
+	static const int s_frames=8;
+	OpenCL *m_cl;
+	std::string m_file;
+	std::string m_deviceKey;
+	Launch m_launch[ParticleKernel::s_numLayouts];
+};
+
+#endif
@@ -3,34 +3,92 @@
 
 #ifdef __APPLE__
   #include <OpenCL/opencl.h>
+  #include <OpenCL/cl_gl_ext.h>
 #else
   #include <CL/opencl.h>
+  #include <CL/cl_gl.h>
 #endif
 #include <string>
+#include <vector>
+#include <stdint.h>
 
 class OpenCL
 {
   public :
     OpenCL(std::string _kernel);
+    /// @brief ctor that can share buffers with the current GL context
+    /// @param _kernel the kernel source to load
+    /// @param _shareGL try to make the context with cl_khr_gl_sharing, the GL context must be current. If the device
+    /// or platform can't do it a normal context is made, check isGLShared()
+    OpenCL(std::string _kernel, bool _shareGL);
+    /// @brief ctor on a given device rather than the setDeviceSelection one, for using more than one device
+    /// @param _kernel the kernel source to load
+    /// @param _shareGL try to make the context with cl_khr_gl_sharing, see above
+    /// @param _device the device in the same form as setDeviceSelection, empty for the selected one
+    OpenCL(std::string _kernel, bool _shareGL, const std::string &_device);
     OpenCL();
+    /// @brief build the program from a kernel source file. The built binary is cached next to the source (or in
+    /// OPENCL_CACHE_DIR) keyed on the device, driver and source so later runs skip the compile, set OPENCL_NO_CACHE
+    /// to always build from source
     void loadKernelSource(const std::string &_fname);
     inline cl_context getContext() const {return m_context;}
     inline cl_kernel getKernel() const {return m_kernel;}
+    /// @brief the program from loadKernelSource, for making more than the one kernel from it
+    inline cl_program getProgram() const {return m_program;}
     inline cl_command_queue getCommands() const {return m_commands;}
+    /// @brief a second in order queue on the same device for copies, so a read back can run alongside the next
+    /// kernel on getCommands(). Anything shared between the two has to be ordered with events
+    inline cl_command_queue getTransfer() const {return m_transfer;}
     inline cl_device_id getID()const {return m_deviceID;}
+    /// @brief a hash of the device, platform and driver versions as hex, for keying anything cached per device
+    std::string deviceKey() const;
+    /// @brief the device name for logs
+    std::string deviceName() const;
+    /// @brief true if the context was made against the GL context so GL buffers can be used by the kernels
+    inline bool isGLShared() const {return m_glShared;}
     void createKernel(const std::string &_name);
     ~OpenCL();
     void printError(int _err) const ;
     static void printCLInfo()  ;
+    /// @brief choose the device used by any OpenCL made after this, overrides the OPENCL_DEVICE environment
+    /// variable. One of gpu, cpu or accelerator for the first device of that type, platform:device indices as
+    /// listed by printCLInfo (e.g. 1:0), or any other text to match against the platform / device vendor and name
+    /// (e.g. nvidia, pocl). Empty or default picks a GPU then a CPU device.
+    static void setDeviceSelection(const std::string &_spec);
+    /// @brief the devices to split the particles across, overrides the OPENCL_DEVICES environment variable. Either
+    /// all for every device or a comma separated list of anything setDeviceSelection takes (e.g. gpu,cpu)
+    static void setDeviceSplit(const std::string &_spec);
+    /// @brief the devices from setDeviceSplit as platform:device indices for the ctor, without repeats. Empty if the
+    /// particles aren't split
+    static std::vector<std::string> splitDevices();
 
   private :
-    void initCL();
+    void initCL(bool _shareGL=false, const std::string &_device="");
+    /// @brief hash of the device, platform and driver versions
+    uint64_t deviceHash() const;
+    /// @brief deviceHash and the source, a new driver or an edit gives a new key
+    uint64_t binaryKey(const std::string &_source) const;
+    /// @brief the cache file for a kernel source and key, empty if caching is off
+    static std::string binaryPath(const std::string &_fname, uint64_t _key);
+    /// @brief make m_program from a cached binary, false (and no program) if it is missing, stale or won't build
+    bool loadBinary(const std::string &_path, uint64_t _key);
+    /// @brief write m_program's binary to the cache, failures are ignored as it is only a cache
+    void saveBinary(const std::string &_path, uint64_t _key) const;
+    /// @brief find the device asked for, 0 if there are no devices at all
+    /// @param _spec the device as setDeviceSelection takes it, empty for setDeviceSelection / OPENCL_DEVICE
+    static cl_device_id selectDevice(const std::string &_spec);
+    /// @brief set by setDeviceSelection
+    static std::string s_deviceSelection;
+    /// @brief set by setDeviceSplit
+    static std::string s_deviceSplit;
 
     cl_device_id m_deviceID;             // compute device id
     cl_context m_context;                 // compute context
     cl_command_queue m_commands;          // compute command queue
+    cl_command_queue m_transfer;          // transfer command queue
     cl_program m_program;                 // compute program
     cl_kernel m_kernel;                   // compute kernel
+    bool m_glShared;                      // context shares with GL
 
 
 
@@ -0,0 +1,189 @@
+#ifndef PARTICLEKERNEL_H__
+#define PARTICLEKERNEL_H__
+#include "OpenCL.h"
+#include <sim/CLHostSystem.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ParticleKernel
+/// @brief runs the updateparticle kernels with the particles kept on the device. They are uploaded once when this
+/// is made, after that each frame sets the arguments, runs the kernel (which does the positions, life and respawn)
+/// and either reads back just the positions or, if made on GL vertex buffers, leaves them in the buffers for the
+/// draw. Used by the Emitter and the Benchmark so both run the same pipeline.
+///
+/// Nothing blocks on the frame just queued. The positions are double buffered (slot()) and the enqueues are chained
+/// with events, the kernel on the compute queue and the read back on the transfer queue, so frame N's read back runs
+/// alongside frame N+1's kernel and the host carries on with its own work while both run. Each update returns once
+/// the frame before it is complete, so the caller always has one frame finished and one in flight.
+///
+/// The particles are either kept as the 28 byte sim::CLParticle structs (AOS) or as separate direction and life
+/// arrays updated 4 or 8 at a time with vector loads and stores (SOA4 / SOA8), see updateparticle.cl. All of them
+/// give the same positions.
+///
+/// The queues are made with profiling on and every command keeps its event until its frame completes, then the
+/// device timestamps are read into profile(), so the kernel time can be told apart from the transfers.
+//----------------------------------------------------------------------------------------------------------------------
+class ParticleKernel
+{
+public :
+	/// @brief the number of frames that can be in flight
+	static const int s_buffers=2;
+	/// @brief how the particles are laid out on the device, and so which kernel is run
+	enum Layout {AOS,SOA4,SOA8};
+	/// @brief the number of layouts, for cycling through them
+	static const int s_numLayouts=3;
+	/// @brief a name for the logs and reports
+	static const char *layoutName(Layout _layout);
+	/// @brief setRange starts have to be a multiple of this so every SoA vector belongs to one range
+	static const size_t s_rangeAlignment=8;
+	/// @brief the most commands in one frame (acquire, kernel, release) or in the upload (four SoA writes)
+	static const int s_maxCommands=4;
+	/// @brief the device timestamps for one command from clGetEventProfilingInfo, in ns on the device clock and 0 if
+	/// the device couldn't give them
+	struct Command
+	{
+		/// @brief "write", "acquire", "kernel", "read" or "release"
+		const char *m_name;
+		cl_ulong m_queued;
+		cl_ulong m_submit;
+		cl_ulong m_start;
+		cl_ulong m_end;
+		/// @brief true for the copies and GL hand overs, false for the kernel
+		bool isTransfer() const;
+	};
+	/// @brief the commands for one frame in the order they were queued
+	struct Profile
+	{
+		/// @brief the frame the commands were for
+		cl_uint m_frame;
+		int m_numCommands;
+		Command m_commands[s_maxCommands];
+		/// @brief the kernel run time in ms
+		double compute() const;
+		/// @brief the run time of everything else in ms
+		double transfer() const;
+		/// @brief first start to last end in ms, less than compute + transfer when they overlap other frames
+		double span() const;
+	};
+	/// @brief ctor makes the device buffers and uploads the particles
+	/// @param _cl the OpenCL context with updateparticle.cl loaded
+	/// @param _particles the host particles, these give the start state, emitter position and emit direction
+	/// @param _layout the device layout and kernel to use
+	ParticleKernel(OpenCL *_cl, sim::CLHostSystem *_particles, Layout _layout=AOS);
+	/// @brief ctor that writes the positions straight into GL vertex buffers, needs a context made with
+	/// OpenCL::isGLShared(). If the buffers can't be shared this is the same as the other ctor, check isShared()
+	/// @param _cl the OpenCL context with updateparticle.cl loaded
+	/// @param _particles the host particles, these give the start state, emitter position and emit direction
+	/// @param _vbos the GL buffers to write, one per slot and each at least size() GLParticles
+	/// @param _layout the device layout and kernel to use
+	ParticleKernel(OpenCL *_cl, sim::CLHostSystem *_particles, const cl_GLuint _vbos[s_buffers], Layout _layout=AOS);
+	/// @brief dtor waits for anything in flight and releases the device buffers
+	~ParticleKernel();
+	/// @brief queue one frame, the positions are read back into o_positions as the device gets to it. Returns once
+	/// the previous call's positions are complete, o_positions has to stay valid until the next update or finish
+	/// @param _wind the wind vector to use
+	/// @param o_positions where to read this frame's positions to, normally the mapped VBO for slot()
+	void update(const sim::Vec3 &_wind, sim::GLParticle *o_positions);
+	/// @brief queue one frame like update but don't wait for the previous one, for running several kernels in step
+	/// (SplitKernel). Call complete() before the next submit
+	/// @param _wind the wind vector to use
+	/// @param _end the emit direction for the frame, sim::CLHostSystem::nextDirection() once for all the kernels
+	/// @param o_positions the whole position array, only this kernel's range is written
+	void submit(const sim::Vec3 &_wind, const sim::Vec3 &_end, sim::GLParticle *o_positions);
+	/// @brief wait for the frame before the last submit, after this its positions and profile() are complete
+	inline void complete() {wait(slot());}
+	/// @brief queue one frame writing the shared GL buffer for slot(). GL must have finished with that buffer (a
+	/// fence after its last draw) before this is called. Returns once the previous frame's buffer is back with GL
+	/// @param _wind the wind vector to use
+	void update(const sim::Vec3 &_wind);
+	/// @brief wait for every frame in flight, after this the last update's positions are complete
+	void finish();
+	/// @brief the slot the next update writes, after the update the other slot holds the finished frame
+	inline int slot() const {return static_cast<int>(m_frame%s_buffers);}
+	/// @brief true if the positions go to the GL buffers rather than being read back
+	inline bool isShared() const {return m_shared;}
+	inline Layout layout() const {return m_layout;}
+	/// @brief set the launch shape, see KernelTuner. The default is the kernel's largest work group and one vector
+	/// of particles per work item
+	/// @param _local the work group size, 0 lets the runtime choose, anything over maxLocalSize() is clamped
+	/// @param _perItem how many vectors of particles each work item does, the kernels stride by the global size
+	void setLaunch(size_t _local, size_t _perItem);
+	inline size_t localSize() const {return m_local;}
+	inline size_t perItem() const {return m_perItem;}
+	/// @brief the largest work group the kernel can be run with on this device
+	inline size_t maxLocalSize() const {return m_workgroupsize;}
+	inline size_t size() const {return m_numParticles;}
+	/// @brief only update particles _first to _first+_count-1, the rest are left as they are on this device. Every
+	/// kernel has all the particles so the range can move, see copyParticles
+	/// @param _first the first particle, a multiple of s_rangeAlignment
+	/// @param _count how many to update, more than 0
+	void setRange(size_t _first, size_t _count);
+	inline size_t first() const {return m_first;}
+	inline size_t count() const {return m_count;}
+	/// @brief copy the device state of some particles from another kernel of the same layout, for when a range moves
+	/// from one device to another. Blocks, neither kernel can have frames in flight
+	/// @param _from the kernel that has been updating the particles
+	/// @param _first the first particle to copy
+	/// @param _count how many to copy
+	void copyParticles(const ParticleKernel &_from, size_t _first, size_t _count);
+	/// @brief the timestamps for the last complete frame, updated by each update and finish
+	inline const Profile &profile() const {return m_profile;}
+	/// @brief the timestamps for the writes that uploaded the particles in the ctor
+	inline const Profile &uploadProfile() const {return m_upload;}
+
+private :
+	/// @brief the kernel, input buffers and upload, common to both ctors
+	void init();
+	/// @brief set the arguments and queue the kernel for slot()
+	/// @param _wind the wind vector to use
+	/// @param _numWait the number of events the kernel waits on
+	/// @param _wait the events the kernel waits on
+	/// @param o_done set to the kernel's event
+	/// @param _end the emit direction for the frame
+	void enqueue(const sim::Vec3 &_wind, const sim::Vec3 &_end, cl_uint _numWait, const cl_event *_wait, cl_event *o_done);
+	/// @brief wait for and release the event for a slot if there is one, then collect its profile
+	void wait(int _slot);
+	/// @brief keep a command's event for the slot's profile, takes over the event's reference
+	void record(int _slot, const char *_name, cl_event _event);
+	/// @brief read the timestamps for a finished command
+	static void readTimes(cl_event _event, const char *_name, Command &o_command);
+	OpenCL *m_cl;
+	sim::CLHostSystem *m_particles;
+	size_t m_numParticles;
+	/// @brief the particles the kernel updates, all of them unless setRange is used
+	size_t m_first;
+	size_t m_count;
+	Layout m_layout;
+	/// @brief particles per work item, 1 for AOS
+	size_t m_width;
+	/// @brief the kernel for m_layout, made from the OpenCL program
+	cl_kernel m_kernel;
+	/// @brief the particles, these only ever live on the device after the ctor. AOS uses the first as the
+	/// CLParticle array, SOA uses all four as the x, y, z direction and life arrays padded to m_width
+	cl_mem m_input[4];
+	/// @brief the positions for each slot, either device buffers or the shared GL buffers
+	cl_mem m_output[s_buffers];
+	/// @brief the last command on each slot (the read back or the GL release), 0 when the slot is idle
+	cl_event m_done[s_buffers];
+	bool m_shared;
+	/// @brief CL_KERNEL_WORK_GROUP_SIZE for m_kernel
+	size_t m_workgroupsize;
+	/// @brief the work group size used, 0 for the runtime's choice
+	size_t m_local;
+	size_t m_perItem;
+	/// @brief work items rounded up to a whole number of work groups
+	size_t m_globalSize;
+	/// @brief frames run so far, the counter for the respawn random numbers
+	cl_uint m_frame;
+	/// @brief every command for the frame in each slot, kept until the frame is complete
+	cl_event m_events[s_buffers][s_maxCommands];
+	const char *m_eventNames[s_buffers][s_maxCommands];
+	int m_numEvents[s_buffers];
+	cl_uint m_eventFrame[s_buffers];
+	Profile m_profile;
+	Profile m_upload;
+	// owns device buffers so no copies
+	ParticleKernel(const ParticleKernel &);
+	ParticleKernel &operator=(const ParticleKernel &);
+};
+
+#endif
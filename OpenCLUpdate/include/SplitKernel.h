@@ -0,0 +1,73 @@
+#ifndef SPLITKERNEL_H__
+#define SPLITKERNEL_H__
+#include <vector>
+#include "OpenCL.h"
+#include "ParticleKernel.h"
+#include <sim/CLHostSystem.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class SplitKernel
+/// @brief runs one ParticleKernel per device, each updating its own range of the particles and reading its positions
+/// into its part of the same array. Every device has a copy of all the particles but only its range is kept up to
+/// date, the ranges are contiguous in device order. The kernels run in step, all of a frame is queued before any
+/// device is waited on, and each frame the device times from the profiles (the kernel and its read back) give each
+/// device's rate. When the rates say the split is off by more than a little the pipeline is drained and the ranges
+/// move, only the particles changing device are copied across (through the host as the devices have their own
+/// contexts). The respawns only depend on the particle index and frame so the positions are the same as one device.
+//----------------------------------------------------------------------------------------------------------------------
+class SplitKernel
+{
+public :
+	/// @brief ctor makes a kernel on each device and gives each a starting range
+	/// @param _cls one context per device with updateparticle.cl loaded, none of them GL shared as the positions are
+	/// always read back
+	/// @param _particles the host particles, these give the start state, emitter position and emit direction
+	/// @param _layout the device layout and kernel to use on every device
+	/// @param _speeds a relative speed per device for the first split (e.g. 1/ns per particle from KernelTuner), an
+	/// even split if empty or any are 0
+	SplitKernel(const std::vector<OpenCL *> &_cls, sim::CLHostSystem *_particles, ParticleKernel::Layout _layout,
+							const std::vector<double> &_speeds);
+	/// @brief dtor waits for the devices and deletes the kernels, the contexts are the caller's
+	~SplitKernel();
+	/// @brief queue one frame on every device then wait for the previous frame, as ParticleKernel::update, then
+	/// rebalance the ranges if needed
+	/// @param _wind the wind vector to use
+	/// @param o_positions the whole position array, has to stay valid until the next update or finish
+	void update(const sim::Vec3 &_wind, sim::GLParticle *o_positions);
+	/// @brief wait for every frame in flight on every device
+	void finish();
+	/// @brief the slot the next update writes, the same on every device
+	inline int slot() const {return m_kernels[0]->slot();}
+	inline ParticleKernel::Layout layout() const {return m_layout;}
+	inline size_t numDevices() const {return m_kernels.size();}
+	/// @brief the kernel for a device, for its range, launch and profile
+	inline ParticleKernel *kernel(size_t _device) {return m_kernels[_device];}
+	/// @brief how many times the ranges have moved
+	inline int moves() const {return m_moves;}
+
+private :
+	/// @brief update the rates from the last complete frame and move the ranges if they are out
+	void balance();
+	/// @brief the ranges for a set of relative rates, aligned and with a minimum for each device
+	/// @param _rates a rate per device
+	/// @param o_firsts the first particle for each device, plus the particle count at the end
+	void split(const std::vector<double> &_rates, std::vector<size_t> &o_firsts) const;
+	/// @brief drain the devices, copy the particles that change device and set the new ranges
+	/// @param _firsts from split
+	void moveTo(const std::vector<size_t> &_firsts);
+	sim::CLHostSystem *m_particles;
+	ParticleKernel::Layout m_layout;
+	std::vector<ParticleKernel *> m_kernels;
+	/// @brief particles per ms for each device, smoothed over frames
+	std::vector<double> m_rates;
+	/// @brief frames submitted so far, the same as each kernel's frame count
+	cl_uint m_frame;
+	/// @brief the first frame run on the current ranges, earlier profiles are for the old ones
+	cl_uint m_settled;
+	int m_moves;
+	// owns the kernels so no copies
+	SplitKernel(const SplitKernel &);
+	SplitKernel &operator=(const SplitKernel &);
+};
+
+#endif
@@ -29,11 +29,141 @@ typedef struct Vec3
   float m_z;
 }Vec3;
 
-__kernel void updateparticle( __global Particle* input,   __global GLParticle* output, Vec3 wind, Vec3 pos, float gravity)
+/// @brief Philox4x32-10, the same as sim/Philox.h so a respawn here can be checked against
+/// sim::RandomStream::uniformAt(seed, particle, frame) on the host
+uint4 philox(uint4 _c, uint _k0, uint _k1)
 {
-   unsigned int i = get_global_id(0);
-   output[i].px=pos.m_x+(wind.m_x*input[i].m_dx*input[i].m_currentLife);
-   output[i].py= pos.m_y+(wind.m_y*input[i].m_dy*input[i].m_currentLife)+gravity*(input[i].m_currentLife*input[i].m_currentLife);
-   output[i].pz=pos.m_z+(wind.m_z*input[i].m_dz*input[i].m_currentLife);
+	for(int r=0; r<10; ++r)
+	{
+		uint hi0=mul_hi(0xD2511F53u,_c.x);
+		uint lo0=0xD2511F53u*_c.x;
+		uint hi1=mul_hi(0xCD9E8D57u,_c.z);
+		uint lo1=0xCD9E8D57u*_c.z;
+		_c=(uint4)(hi1^_c.y^_k0, lo1, hi0^_c.w^_k1, lo0);
+		_k0+=0x9E3779B9u;
+		_k1+=0xBB67AE85u;
+	}
+	return _c;
+}
 
+/// @brief the top 24 bits as a float in [0,1)
+float toFloat(uint _x)
+{
+	return (float)(_x>>8)*(1.0f/16777216.0f);
+}
+
+/// @brief the whole update on the device, the particles stay in _particles from one frame to the next and only the
+/// positions are written out. The position is from the life at the start of the frame, as the host loop did, then
+/// the life moves on and anything below the emitter respawns. A particle respawns at most once a frame so
+/// (frame, particle) is a unique counter for its random numbers and there is no generator state to keep.
+/// Each work item strides over the particles by the global size so the launch can give it as many as it likes
+/// (ParticleKernel::setLaunch), the global size is rounded up to whole work groups so it may have none. Only the
+/// particles from first up to last are updated so several devices can each do part of the array (SplitKernel), the
+/// index is always the particle's place in the whole array so the respawns don't depend on the split.
+__kernel void updateparticle( __global Particle* input,   __global GLParticle* output, Vec3 wind, Vec3 pos, float gravity,
+                              Vec3 end, float step, uint seedLo, uint seedHi, uint frame, uint first, uint last)
+{
+  for(uint i = first + get_global_id(0); i < last; i += get_global_size(0))
+  {
+   Particle p=input[i];
+   float px=pos.m_x+(wind.m_x*p.m_dx*p.m_currentLife);
+   float py=pos.m_y+(wind.m_y*p.m_dy*p.m_currentLife)+gravity*(p.m_currentLife*p.m_currentLife);
+   float pz=pos.m_z+(wind.m_z*p.m_dz*p.m_currentLife);
+   output[i].px=px;
+   output[i].py=py;
+   output[i].pz=pz;
+   p.m_currentLife+=step;
+   // if we go below the origin re-set
+   if(py <= pos.m_y-0.01f)
+   {
+     uint4 r=philox((uint4)(frame,0,i,0),seedLo,seedHi);
+     p.m_px=pos.m_x;
+     p.m_py=pos.m_y;
+     p.m_pz=pos.m_z;
+     p.m_currentLife=0.0f;
+     // the same mapping as randomNumber(2) / randomPositiveNumber(10)
+     p.m_dx=end.m_x+(toFloat(r.x)*2.0f-1.0f)*2.0f+0.5f;
+     p.m_dy=end.m_y+toFloat(r.y)*10.0f+0.5f;
+     p.m_dz=end.m_z+(toFloat(r.z)*2.0f-1.0f)*2.0f+0.5f;
+   }
+   input[i]=p;
+  }
 }
+
+/// @brief respawn one particle of the SoA layout, the same numbers and mapping as updateparticle
+void respawnSoA(uint _i, Vec3 _end, uint _seedLo, uint _seedHi, uint _frame,
+                __global float *o_dx, __global float *o_dy, __global float *o_dz, __global float *o_life)
+{
+  uint4 r=philox((uint4)(_frame,0,_i,0),_seedLo,_seedHi);
+  o_life[_i]=0.0f;
+  o_dx[_i]=_end.m_x+(toFloat(r.x)*2.0f-1.0f)*2.0f+0.5f;
+  o_dy[_i]=_end.m_y+toFloat(r.y)*10.0f+0.5f;
+  o_dz[_i]=_end.m_z+(toFloat(r.z)*2.0f-1.0f)*2.0f+0.5f;
+}
+
+/// @brief write four particles' positions interleaved x,y,z as the VBO wants them, three aligned float4 stores
+void storePositions4(float4 _x, float4 _y, float4 _z, uint _particle, __global float *o_output)
+{
+  __global float *out=o_output+_particle*3;
+  vstore4((float4)(_x.s0,_y.s0,_z.s0,_x.s1),0,out);
+  vstore4((float4)(_y.s1,_z.s1,_x.s2,_y.s2),0,out+4);
+  vstore4((float4)(_z.s2,_x.s3,_y.s3,_z.s3),0,out+8);
+}
+
+void storePositions8(float8 _x, float8 _y, float8 _z, uint _particle, __global float *o_output)
+{
+  storePositions4(_x.lo,_y.lo,_z.lo,_particle,o_output);
+  storePositions4(_x.hi,_y.hi,_z.hi,_particle+4,o_output);
+}
+
+/// @brief the same update on a structure of arrays, each work item does N neighbouring particles with floatN loads
+/// so every access is a whole aligned vector and a work group reads and writes one contiguous block of each array.
+/// Only the direction and life are needed (the position is worked out from them) so that is all that is kept. The
+/// arrays are padded to a multiple of N, the last work item writes its positions one at a time so the output (the
+/// VBO) doesn't need to be. Respawns are rare so they are done a lane at a time when any lane needs one. Like
+/// updateparticle each work item strides by the global size, a vector at a time, from first (a multiple of N) to last.
+#define UPDATE_SOA(N) \
+__kernel void updateparticle_soa##N(__global float *dx, __global float *dy, __global float *dz, __global float *life, \
+                                    __global float *output, Vec3 wind, Vec3 pos, float gravity, Vec3 end, float step, \
+                                    uint seedLo, uint seedHi, uint frame, uint first, uint last) \
+{ \
+  for(uint base=first+get_global_id(0)*N; base < last; base += get_global_size(0)*N) \
+  { \
+    float##N l=vload##N(0,life+base); \
+    float##N px=pos.m_x+(wind.m_x*vload##N(0,dx+base)*l); \
+    float##N py=pos.m_y+(wind.m_y*vload##N(0,dy+base)*l)+gravity*(l*l); \
+    float##N pz=pos.m_z+(wind.m_z*vload##N(0,dz+base)*l); \
+    if(base+N <= last) \
+    { \
+      storePositions##N(px,py,pz,base,output); \
+    } \
+    else \
+    { \
+      float xs[N], ys[N], zs[N]; \
+      vstore##N(px,0,xs); \
+      vstore##N(py,0,ys); \
+      vstore##N(pz,0,zs); \
+      for(uint k=0; base+k < last; ++k) \
+      { \
+        output[(base+k)*3]=xs[k]; \
+        output[(base+k)*3+1]=ys[k]; \
+        output[(base+k)*3+2]=zs[k]; \
+      } \
+    } \
+    vstore##N(l+step,0,life+base); \
+    /* if we go below the origin re-set */ \
+    if(any(py <= pos.m_y-0.01f)) \
+    { \
+      float ys[N]; \
+      vstore##N(py,0,ys); \
+      for(uint k=0; k<N && base+k < last; ++k) \
+      { \
+        if(ys[k] <= pos.m_y-0.01f) \
+          respawnSoA(base+k,end,seedLo,seedHi,frame,dx,dy,dz,life); \
+      } \
+    } \
+  } \
+}
+
+UPDATE_SOA(4)
+UPDATE_SOA(8)
@@ -1,100 +1,227 @@
 #include "Emitter.h"
-#include <ngl/Random.h>
 #include <ngl/Transformation.h>
 #include <ngl/ShaderLib.h>
 #include <ngl/VAOPrimitives.h>
 #include <ngl/Logger.h>
 #include <QElapsedTimer>
 #include <ngl/NGLStream.h>
+#include <vector>
 /// @brief ctor
 /// @param _pos the position of the emitter
 /// @param _numParticles the number of particles to create
-Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind )
+Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind ) :
+	m_particles(sim::Vec3(_pos.m_x,_pos.m_y,_pos.m_z),_numParticles)
 {
 
 
 	OpenCL::printCLInfo();
-	m_cl = new OpenCL("kernel/updateparticle.cl");
-	m_cl->createKernel("updateparticle");
-	m_time=0.0;
-
-	m_input = clCreateBuffer(m_cl->getContext(),  CL_MEM_READ_WRITE,  sizeof(Particle) * _numParticles, NULL, NULL);
-	m_output = clCreateBuffer(m_cl->getContext(), CL_MEM_WRITE_ONLY, sizeof(GLParticle) * _numParticles, NULL, NULL);
-	if (!m_input || !m_output)
+	// with --cl-devices the particles are split across the devices, each has its own context so the positions are
+	// read back rather than shared with GL
+	std::vector<std::string> devices=OpenCL::splitDevices();
+	if(devices.size() > 1)
 	{
-			std::cerr<<"Error: Failed to allocate device memory!\n";
-			exit(EXIT_FAILURE);
+		m_cl = new OpenCL("kernel/updateparticle.cl",false,devices[0]);
+		for(size_t i=1; i<devices.size(); ++i)
+		{
+			m_others.push_back(new OpenCL("kernel/updateparticle.cl",false,devices[i]));
+		}
+	}
+	else
+	{
+		// ask for a context shared with GL so the kernel can write the VBO, this needs the GL context current. A one
+		// device list is just that device, as in the Benchmark's split variant
+		m_cl = new OpenCL("kernel/updateparticle.cl",true,devices.empty() ? std::string() : devices[0]);
 	}
-
-  // Get the maximum work group size for executing the kernel on the device
-  //
-  int err;
-  err = clGetKernelWorkGroupInfo(m_cl->getKernel(), m_cl->getID(), CL_KERNEL_WORK_GROUP_SIZE, sizeof(m_workgroupsize), &m_workgroupsize, NULL);
-  std::cout<<"work group size is "<<m_workgroupsize<<"\n";
-  if (err != CL_SUCCESS)
-  {
-      std::cerr<<"Error: Failed to retrieve kernel work group info "<<err<<"\n";
-      exit(EXIT_FAILURE);
-  }
 
 
 	m_wind=_wind;
-	Particle p;
-	GLParticle g;
-	ngl::Random *rand=ngl::Random::instance();
 	ngl::Logger *log = ngl::Logger::instance();
 	log->logMessage("Starting emitter ctor\n");
 	QElapsedTimer timer;
 	timer.start();
-	m_pos=_pos;
-	m_particles = new Particle[_numParticles];
-	m_glparticles = new GLParticle[_numParticles];
-	m_vao=ngl::VertexArrayObject::createVOA(GL_POINTS);
-	float pointOnCircleX= cos(ngl::radians(m_time))*4.0;
-	float pointOnCircleZ= sin(ngl::radians(m_time))*4.0;
-	ngl::Vec3 end(pointOnCircleX,2.0,pointOnCircleZ);
-	end=end-m_pos;
-
+	// the first positions only live here until they are in the VBOs, after that the kernel output is read straight
+	// into them
+	std::vector<sim::GLParticle> positions(_numParticles);
+	const sim::CLParticle *particles=m_particles.particles();
 	for (int i=0; i< _numParticles; ++i)
-	{		
+	{
+		positions[i].px=particles[i].m_px;
+		positions[i].py=particles[i].m_py;
+		positions[i].pz=particles[i].m_pz;
+	}
+	m_numParticles=_numParticles;
+	for(int i=0; i<ParticleKernel::s_buffers; ++i)
+	{
+		m_vao[i]=ngl::VertexArrayObject::createVOA(GL_POINTS);
+		m_vao[i]->bind();
+		// create the VAO and stuff data
+		m_vao[i]->setData(m_numParticles*sizeof(sim::GLParticle),positions[0].px);
+		m_vao[i]->setVertexAttributePointer(0,3,GL_FLOAT,sizeof(sim::GLParticle),0);
+		// setData leaves the VBO bound so this is the buffer the positions are in
+		GLint vbo=0;
+		glGetIntegerv(GL_ARRAY_BUFFER_BINDING,&vbo);
+		m_vbo[i]=static_cast<GLuint>(vbo);
+		m_mapped[i]=0;
+		m_fence[i]=0;
+// uv same as above but starts at 0 and is attrib 1 and only u,v so 2
+//m_vao->setVertexAttributePointer(1,3,GL_FLOAT,sizeof(sim::GLParticle),3);
+		m_vao[i]->setNumIndices(m_numParticles);
+		m_vao[i]->unbind();
+	}
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+log->logMessage("Finished filling array took %d milliseconds\n",timer.elapsed());
 
-		g.px=p.m_px=m_pos.m_x;
-		g.py=p.m_py=m_pos.m_y;
-		g.pz=p.m_pz=m_pos.m_z;
-		p.m_dx=end.m_x+rand->randomNumber(2)+0.5;
-		p.m_dy=end.m_y+rand->randomPositiveNumber(10)+0.5;
-		p.m_dz=end.m_z+rand->randomNumber(2)+0.5;
+	m_kernel=0;
+	m_split=0;
+	// the first run on a device times every layout and launch, after that it is read from the file
+	m_tuner = new KernelTuner(m_cl,"kernel/updateparticle.cl.tune");
+	for(size_t i=0; i<m_others.size(); ++i)
+	{
+		m_otherTuners.push_back(new KernelTuner(m_others[i],"kernel/updateparticle.cl.tune"));
+	}
+	makeKernel(m_tuner->fastest());
+}
 
-		p.m_currentLife=0.0;
-//		p.m_maxLife=rand->randomNumber(3)+0.5;
-//		p.m_gravity=-9;//4.65;
+void Emitter::makeKernel(ParticleKernel::Layout _layout)
+{
+	// nothing can still be writing the buffers when the old kernel goes
+	if(m_kernel)
+	{
+		m_kernel->finish();
+		delete m_kernel;
+		m_kernel=0;
+	}
+	if(m_split)
+	{
+		m_split->finish();
+		delete m_split;
+		m_split=0;
+	}
+	for(int i=0; i<ParticleKernel::s_buffers; ++i)
+	{
+		if(m_mapped[i])
+		{
+			glBindBuffer(GL_ARRAY_BUFFER,m_vbo[i]);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			m_mapped[i]=0;
+		}
+		if(m_fence[i])
+		{
+			glClientWaitSync(m_fence[i],GL_SYNC_FLUSH_COMMANDS_BIT,GL_TIMEOUT_IGNORED);
+			glDeleteSync(m_fence[i]);
+			m_fence[i]=0;
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+	// a new kernel starts on slot 0 so draw the other one until it is done
+	m_draw=1;
 
+	ngl::Logger *log = ngl::Logger::instance();
+	if(!m_others.empty())
+	{
+		// every device gets all the particles and a range to update, the first split is from the tuned speeds
+		std::vector<OpenCL *> cls(1,m_cl);
+		cls.insert(cls.end(),m_others.begin(),m_others.end());
+		std::vector<KernelTuner *> tuners(1,m_tuner);
+		tuners.insert(tuners.end(),m_otherTuners.begin(),m_otherTuners.end());
+		std::vector<double> speeds;
+		for(size_t i=0; i<tuners.size(); ++i)
+		{
+			double ns=tuners[i]->launch(_layout).m_nsPerParticle;
+			speeds.push_back(ns > 0.0 ? 1.0/ns : 0.0);
+		}
+		m_split = new SplitKernel(cls,&m_particles,_layout,speeds);
+		log->logMessage("Using the %s kernel split across %d devices\n",ParticleKernel::layoutName(_layout),int(cls.size()));
+		for(size_t i=0; i<tuners.size(); ++i)
+		{
+			tuners[i]->apply(m_split->kernel(i));
+			log->logMessage("%s particles %d to %d, work group %d with %d per work item\n",cls[i]->deviceName().c_str(),
+											int(m_split->kernel(i)->first()),int(m_split->kernel(i)->first()+m_split->kernel(i)->count()),
+											int(m_split->kernel(i)->localSize()),int(m_split->kernel(i)->perItem()));
+		}
+		return;
+	}
+	// the particles are uploaded here and stay on the device, if the context is shared the kernel writes the VBOs
+	// otherwise the positions are read back into them
+	if(m_cl->isGLShared())
+	{
+		cl_GLuint vbos[ParticleKernel::s_buffers];
+		for(int i=0; i<ParticleKernel::s_buffers; ++i)
+		{
+			vbos[i]=m_vbo[i];
+		}
+		m_kernel = new ParticleKernel(m_cl,&m_particles,vbos,_layout);
+	}
+	else
+	{
+		m_kernel = new ParticleKernel(m_cl,&m_particles,_layout);
+	}
+	m_tuner->apply(m_kernel);
+	log->logMessage("Using the %s kernel\n",ParticleKernel::layoutName(_layout));
+	log->logMessage("Work group %d with %d per work item\n",int(m_kernel->localSize()),int(m_kernel->perItem()));
+	log->logMessage(m_kernel->isShared() ? "Kernel writes the VBO directly\n" : "Kernel output is copied to the VBO\n");
+	logProfile("Upload",m_kernel->uploadProfile());
+}
 
-		m_particles[i]=p;
-		m_glparticles[i]=g;
+void Emitter::logProfile(const char *_what, const ParticleKernel::Profile &_profile)
+{
+	if(_profile.m_numCommands == 0)
+	{
+		return;
 	}
-	m_numParticles=_numParticles;
-	m_vao->bind();
-	// create the VAO and stuff data
-	m_vao->setData(m_numParticles*sizeof(GLParticle),m_glparticles[0].px);
-	m_vao->setVertexAttributePointer(0,3,GL_FLOAT,sizeof(GLParticle),0);
-// uv same as above but starts at 0 and is attrib 1 and only u,v so 2
-//m_vao->setVertexAttributePointer(1,3,GL_FLOAT,sizeof(GLParticle),3);
-m_vao->setNumIndices(m_numParticles);
-m_vao->unbind();
-log->logMessage("Finished filling array took %d milliseconds\n",timer.elapsed());
+	ngl::Logger *log = ngl::Logger::instance();
+	log->logMessage("%s %d device time: compute %0.3f ms transfer %0.3f ms span %0.3f ms\n",_what,int(_profile.m_frame),
+									_profile.compute(),_profile.transfer(),_profile.span());
+	// relative to the first command being queued, the gaps are the time spent behind the other queue or frame
+	cl_ulong base=_profile.m_commands[0].m_queued;
+	for(int i=0; i<_profile.m_numCommands; ++i)
+	{
+		const ParticleKernel::Command &command=_profile.m_commands[i];
+		log->logMessage("  %-8s queued %0.3f submit %0.3f start %0.3f end %0.3f ms\n",command.m_name,
+										(command.m_queued-base)/1.0e6,(command.m_submit-base)/1.0e6,(command.m_start-base)/1.0e6,(command.m_end-base)/1.0e6);
+	}
+}
 
+void Emitter::nextLayout()
+{
+	int next=((m_split ? m_split->layout() : m_kernel->layout())+1)%ParticleKernel::s_numLayouts;
+	makeKernel(static_cast<ParticleKernel::Layout>(next));
 }
 
 
 Emitter::~Emitter()
 {
-	delete [] m_glparticles;
-	delete [] m_particles;
-	clReleaseMemObject(m_input);
-	clReleaseMemObject(m_output);
+	// nothing can still be writing the buffers when they go
+	if(m_kernel)
+	{
+		m_kernel->finish();
+		delete m_kernel;
+	}
+	if(m_split)
+	{
+		m_split->finish();
+		delete m_split;
+	}
+	delete m_tuner;
+	for(size_t i=0; i<m_others.size(); ++i)
+	{
+		delete m_otherTuners[i];
+		delete m_others[i];
+	}
 
-	m_vao->removeVOA();
+	for(int i=0; i<ParticleKernel::s_buffers; ++i)
+	{
+		if(m_mapped[i])
+		{
+			glBindBuffer(GL_ARRAY_BUFFER,m_vbo[i]);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+		if(m_fence[i])
+		{
+			glDeleteSync(m_fence[i]);
+		}
+		m_vao[i]->removeVOA();
+	}
 	delete m_cl;
 }
 
@@ -108,112 +235,71 @@ void Emitter::update()
 	log->logMessage("Starting emitter update\n");
 
 
-	int err;
-	err = clEnqueueWriteBuffer(m_cl->getCommands(), m_input, CL_TRUE, 0, sizeof(float) * m_numParticles, m_particles, 0, NULL, NULL);
-	if (err != CL_SUCCESS)
+	// the kernel does the whole update on the device. With a shared context it writes the VBO itself, otherwise the
+	// positions are read back straight into the mapped VBO, either way nothing is uploaded. This frame goes into
+	// one VBO while the last finished frame in the other is drawn, the kernel returns as soon as that one is done
+	sim::Vec3 wind(m_wind->m_x,m_wind->m_y,m_wind->m_z);
+	int write=slot();
+	if(isShared())
 	{
-			std::cerr<<"Error: Failed to write to source array!\n";
-			exit(EXIT_FAILURE);
+		// GL has to be done with the buffer before CL takes it, only the draw from two frames ago used it
+		if(m_fence[write])
+		{
+			glClientWaitSync(m_fence[write],GL_SYNC_FLUSH_COMMANDS_BIT,GL_TIMEOUT_IGNORED);
+			glDeleteSync(m_fence[write]);
+			m_fence[write]=0;
+		}
+		m_kernel->update(wind);
 	}
-
-  // Set the arguments to our compute kernel
-  //
-  typedef struct Vec3
-  {
-    float m_x;
-    float m_y;
-    float m_z;
-  }Vec3;
-
-  Vec3 wind;
-  wind.m_x=m_wind->m_x;
-  wind.m_y=m_wind->m_y;
-  wind.m_z=m_wind->m_z;
-  Vec3 pos;
-  pos.m_x=m_pos.m_x;
-  pos.m_y=m_pos.m_y;
-  pos.m_z=m_pos.m_z;
-  float gravity=-9.0f;
-  err = 0;
-  err  = clSetKernelArg(m_cl->getKernel(), 0, sizeof(cl_mem), &m_input);
-  err |= clSetKernelArg(m_cl->getKernel(), 1, sizeof(cl_mem), &m_output);
-  err |= clSetKernelArg(m_cl->getKernel(), 2, sizeof(Vec3), &wind);
-  err |= clSetKernelArg(m_cl->getKernel(), 3, sizeof(Vec3), &pos);
-  err |= clSetKernelArg(m_cl->getKernel(), 4, sizeof(float), &gravity);
-
-  if (err != CL_SUCCESS)
-  {
-      std::cerr<<"Error: Failed to set kernel arguments! "<< err<<"\n";
-      exit(EXIT_FAILURE);
-  }
-
-
-
-  // Execute the kernel over the entire range of our 1d input data set
-  // using the maximum number of work group items for this device
-  //
-  err = clEnqueueNDRangeKernel(m_cl->getCommands(), m_cl->getKernel(), 1, NULL, &m_numParticles, &m_workgroupsize, 0, NULL, NULL);
-  if (err)
-  {
-      m_cl->printError(err);
-      std::cerr<<"Error: Failed to execute kernel!\n";
-      exit( EXIT_FAILURE);
-  }
-
-  // Wait for the command commands to get serviced before reading back results
-  //
-  clFinish(m_cl->getCommands());
-
-  // Read back the results from the device to verify the output
-  //
-
-  err = clEnqueueReadBuffer( m_cl->getCommands(), m_output, CL_TRUE, 0, sizeof(GLParticle) * m_numParticles, m_glparticles, 0, NULL, NULL );
-  if (err != CL_SUCCESS)
-  {//
-      std::cerr<<"Error: Failed to read output array "<< err<<"\n";
-      exit(EXIT_FAILURE);
-  }
-
-
-	m_vao->bind();
-
-	m_vao->updateData(m_numParticles*sizeof(GLParticle),m_glparticles[0].px);
-
-	m_vao->unbind();
-	static int rot=0;
-  static float time=0.0;
-	float pointOnCircleX= cos(ngl::radians(time))*4.0;
-	float pointOnCircleZ= sin(ngl::radians(time))*4.0;
-	ngl::Vec3 end(pointOnCircleX,2.0,pointOnCircleZ);
-	end=end-m_pos;
-	//end.normalize();
-	time+=m_time;
-	//std::cout<<end;
-	for(unsigned int i=0; i<m_numParticles; ++i)
+	else
 	{
-		m_particles[i].m_currentLife+=0.02;
-		m_particles[i].m_py=m_glparticles[i].py;
-
-		// if we go below the origin re-set
-		if(m_particles[i].m_py <= m_pos.m_y-0.01)
+		// the read back runs after this returns so the buffer stays mapped until the next update
+		glBindBuffer(GL_ARRAY_BUFFER,m_vbo[write]);
+		GLsizeiptr size=m_numParticles*sizeof(sim::GLParticle);
+		void *mapped=glMapBufferRange(GL_ARRAY_BUFFER,0,size,GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if(mapped==0)
 		{
-			++rot;
-
-			m_particles[i].m_px=m_pos.m_x;
-			m_particles[i].m_pz=m_pos.m_y;
-			m_particles[i].m_px=m_pos.m_z;
-
-			m_particles[i].m_currentLife=0.0;
-			ngl::Random *rand=ngl::Random::instance();
-      m_particles[i].m_dx=end.m_x+rand->randomNumber(2)+0.5;
-      m_particles[i].m_dy=end.m_y+rand->randomPositiveNumber(10)+0.5;
-      m_particles[i].m_dz=end.m_z+rand->randomNumber(2)+0.5;
-
+			// nothing is queued so the frame in flight and the one drawn stay as they are, the next update tries again
+			log->logMessage("Unable to map the vertex buffer, skipping the frame\n");
+			glBindBuffer(GL_ARRAY_BUFFER,0);
+			return;
 		}
-
+		m_mapped[write]=reinterpret_cast<sim::GLParticle *>(mapped);
+		if(m_split)
+		{
+			m_split->update(wind,m_mapped[write]);
+		}
+		else
+		{
+			m_kernel->update(wind,m_mapped[write]);
+		}
+		// the previous frame is complete now so its buffer can go back to GL for the draw
+		int previous=slot();
+		if(m_mapped[previous])
+		{
+			glBindBuffer(GL_ARRAY_BUFFER,m_vbo[previous]);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			m_mapped[previous]=0;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER,0);
 	}
+	m_draw=slot();
 
 	log->logMessage("Finished update array took %d milliseconds\n",timer.elapsed());
+	// the host time above includes waiting on the device, this splits the device side of the frame now complete
+	if(m_split)
+	{
+		for(size_t i=0; i<m_split->numDevices(); ++i)
+		{
+			ParticleKernel *kernel=m_split->kernel(i);
+			log->logMessage("Device %d particles %d to %d\n",int(i),int(kernel->first()),int(kernel->first()+kernel->count()));
+			logProfile("Frame",kernel->profile());
+		}
+	}
+	else
+	{
+		logProfile("Frame",m_kernel->profile());
+	}
 
 }
 /// @brief a method to draw all the particles contained in the system
@@ -255,9 +341,18 @@ void Emitter::draw(const ngl::Mat4 &_rot)
 	shader->setUniform("MVP",_rot*vp);
 //	shader->setUniform("MV",m_cam->getViewMatrix());
 
-	m_vao->bind();
-	m_vao->draw();
-	m_vao->unbind();
+	m_vao[m_draw]->bind();
+	m_vao[m_draw]->draw();
+	m_vao[m_draw]->unbind();
+	if(isShared())
+	{
+		// the next update but one hands this buffer to CL
+		if(m_fence[m_draw])
+		{
+			glDeleteSync(m_fence[m_draw]);
+		}
+		m_fence[m_draw]=glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+	}
 
 	log->logMessage("Finished draw took %d milliseconds\n",timer.elapsed());
 
@@ -0,0 +1,188 @@
+#include "KernelTuner.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+KernelTuner::KernelTuner(OpenCL *_cl, const std::string &_file) :
+	m_cl(_cl), m_file(_file), m_deviceKey(_cl->deviceKey())
+{
+	for(int i=0; i<ParticleKernel::s_numLayouts; ++i)
+	{
+		m_launch[i].m_local=0;
+		m_launch[i].m_perItem=1;
+		m_launch[i].m_nsPerParticle=0.0;
+	}
+	const char *file=getenv("OPENCL_TUNE_FILE");
+	if(file && *file)
+	{
+		m_file=file;
+	}
+	const char *mode=getenv("OPENCL_TUNE");
+	if(mode && (strcmp(mode,"off")==0 || strcmp(mode,"0")==0))
+	{
+		return;
+	}
+	if(!getenv("OPENCL_RETUNE") && load())
+	{
+		std::cerr<<"Using the tuned kernel launch from "<<m_file<<"\n";
+		return;
+	}
+	tune();
+	save();
+}
+
+ParticleKernel::Layout KernelTuner::fastest() const
+{
+	int best=ParticleKernel::AOS;
+	for(int i=0; i<ParticleKernel::s_numLayouts; ++i)
+	{
+		if(m_launch[i].m_nsPerParticle > 0.0 &&
+			 (m_launch[best].m_nsPerParticle == 0.0 || m_launch[i].m_nsPerParticle < m_launch[best].m_nsPerParticle))
+		{
+			best=i;
+		}
+	}
+	return static_cast<ParticleKernel::Layout>(best);
+}
+
+void KernelTuner::apply(ParticleKernel *_kernel) const
+{
+	const Launch &launch=m_launch[_kernel->layout()];
+	// nothing timed so the kernel keeps its default
+	if(launch.m_nsPerParticle > 0.0)
+	{
+		_kernel->setLaunch(launch.m_local,launch.m_perItem);
+	}
+}
+
+void KernelTuner::tune()
+{
+	typedef std::chrono::steady_clock Clock;
+	std::cerr<<"Tuning the particle kernels for "<<m_cl->deviceName()<<", this is only done once\n";
+	// a scratch system so the real particles aren't moved on, the kernels don't care what the values are
+	sim::CLHostSystem scratch(sim::Vec3(0,0,0),s_particles);
+	std::vector<sim::GLParticle> positions[ParticleKernel::s_buffers];
+	for(int i=0; i<ParticleKernel::s_buffers; ++i)
+	{
+		positions[i].resize(s_particles);
+	}
+	// 0 is the runtime's choice, the kernel's largest work group (the old default) is always tried as well
+	const size_t locals[]={0,32,64,128,256,512,1024};
+	const size_t perItems[]={1,2,4,8};
+	sim::Vec3 wind(1,1,1);
+	for(int l=0; l<ParticleKernel::s_numLayouts; ++l)
+	{
+		ParticleKernel::Layout layout=static_cast<ParticleKernel::Layout>(l);
+		ParticleKernel kernel(m_cl,&scratch,layout);
+		std::vector<size_t> tryLocals;
+		for(size_t i=0; i<sizeof(locals)/sizeof(size_t); ++i)
+		{
+			if(locals[i] < kernel.maxLocalSize())
+				tryLocals.push_back(locals[i]);
+		}
+		tryLocals.push_back(kernel.maxLocalSize());
+		Launch &best=m_launch[l];
+		for(size_t i=0; i<tryLocals.size(); ++i)
+		{
+			for(size_t p=0; p<sizeof(perItems)/sizeof(size_t); ++p)
+			{
+				kernel.setLaunch(tryLocals[i],perItems[p]);
+				for(int f=0; f<s_warmup; ++f)
+				{
+					kernel.update(wind,&positions[kernel.slot()][0]);
+				}
+				kernel.finish();
+				Clock::time_point start=Clock::now();
+				for(int f=0; f<s_frames; ++f)
+				{
+					kernel.update(wind,&positions[kernel.slot()][0]);
+				}
+				kernel.finish();
+				double ns=std::chrono::duration<double,std::nano>(Clock::now()-start).count()/(double(s_frames)*s_particles);
+				if(best.m_nsPerParticle == 0.0 || ns < best.m_nsPerParticle)
+				{
+					best.m_local=tryLocals[i];
+					best.m_perItem=perItems[p];
+					best.m_nsPerParticle=ns;
+				}
+			}
+		}
+		std::cerr<<ParticleKernel::layoutName(layout)<<" best with work group "<<best.m_local<<" (0 is the runtime's choice) and "
+						 <<best.m_perItem<<" per work item, "<<best.m_nsPerParticle<<" ns/particle\n";
+	}
+}
+
+bool KernelTuner::load()
+{
+	std::ifstream file(m_file.c_str());
+	if(!file.is_open())
+		return false;
+	bool found[ParticleKernel::s_numLayouts]={false};
+	std::string line;
+	while(std::getline(file,line))
+	{
+		if(line.empty() || line[0]=='#')
+			continue;
+		std::istringstream fields(line);
+		std::string key;
+		int layout;
+		Launch launch;
+		if(!(fields>>key>>layout>>launch.m_local>>launch.m_perItem>>launch.m_nsPerParticle))
+			continue;
+		if(key!=m_deviceKey || layout<0 || layout>=ParticleKernel::s_numLayouts)
+			continue;
+		m_launch[layout]=launch;
+		found[layout]=true;
+	}
+	for(int i=0; i<ParticleKernel::s_numLayouts; ++i)
+	{
+		if(!found[i])
+			return false;
+	}
+	return true;
+}
+
+void KernelTuner::save() const
+{
+	// keep the other devices' lines so one file can serve a machine with several
+	std::vector<std::string> lines;
+	{
+		std::ifstream file(m_file.c_str());
+		std::string line;
+		while(std::getline(file,line))
+		{
+			if(line.empty() || line[0]=='#' || line.compare(0,m_deviceKey.size(),m_deviceKey)==0)
+				continue;
+			lines.push_back(line);
+		}
+	}
+	std::string temp=m_file+".tmp";
+	{
+		std::ofstream file(temp.c_str());
+		if(!file.is_open())
+		{
+			std::cerr<<"Unable to write the kernel tuning to "<<m_file<<"\n";
+			return;
+		}
+		file<<"# ParticleKernel launches from KernelTuner : device key, layout, work group, per work item, ns/particle\n";
+		file<<"# delete a device's lines (or set OPENCL_RETUNE) to time it again\n";
+		for(size_t i=0; i<lines.size(); ++i)
+		{
+			file<<lines[i]<<"\n";
+		}
+		for(int i=0; i<ParticleKernel::s_numLayouts; ++i)
+		{
+			file<<m_deviceKey<<" "<<i<<" "<<m_launch[i].m_local<<" "<<m_launch[i].m_perItem<<" "<<m_launch[i].m_nsPerParticle
+					<<" # "<<m_cl->deviceName()<<" "<<ParticleKernel::layoutName(static_cast<ParticleKernel::Layout>(i))<<"\n";
+		}
+	}
+	if(rename(temp.c_str(),m_file.c_str())!=0)
+	{
+		remove(temp.c_str());
+	}
+}
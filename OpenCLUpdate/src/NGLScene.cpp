@@ -266,6 +266,8 @@ void NGLScene::keyPressEvent(QKeyEvent *_event)
   case Qt::Key_2: m_emitter->decTime(1.0); break;
 
   case Qt::Key_Space : m_wind->set(1,1,1); break;
+  // cycle the AoS / SoA float4 / SoA float8 kernels
+  case Qt::Key_L : m_emitter->nextLayout(); break;
   default : break;
   }
   // finally update the GLWindow and re-draw
@@ -2,7 +2,280 @@
 #include <fstream>
 #include <string>
 #include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <vector>
+// the GL sharing needs the window system's GL library, the demo defines USE_GL_SHARING but headless users of this
+// class (the Benchmark) leave it off so they only link OpenCL
+#ifdef USE_GL_SHARING
+  #ifdef __APPLE__
+    #include <OpenGL/OpenGL.h>
+  #elif defined(_WIN32)
+    #include <windows.h>
+  #else
+    #include <GL/glx.h>
+  #endif
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief true if the device lists one of the GL sharing extensions
+//----------------------------------------------------------------------------------------------------------------------
+static bool deviceCanShareGL(cl_device_id _device)
+{
+  size_t size=0;
+  clGetDeviceInfo(_device, CL_DEVICE_EXTENSIONS, 0, NULL, &size);
+  std::vector<char> extensions(size+1,0);
+  clGetDeviceInfo(_device, CL_DEVICE_EXTENSIONS, size, &extensions[0], NULL);
+  std::string list(&extensions[0]);
+  return list.find("cl_khr_gl_sharing")!=std::string::npos || list.find("cl_APPLE_gl_sharing")!=std::string::npos;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief fill in the context properties for the current GL context
+/// @param _platform the platform the device is on
+/// @param o_props at least 7 entries, zero terminated on return
+/// @returns false if there is no current GL context this can share with (for example Qt using EGL on Linux) or
+/// the build has no GL sharing
+//----------------------------------------------------------------------------------------------------------------------
+static bool glContextProperties(cl_platform_id _platform, cl_context_properties *o_props)
+{
+#ifndef USE_GL_SHARING
+  (void)_platform;
+  (void)o_props;
+  return false;
+#elif defined(__APPLE__)
+  (void)_platform;
+  CGLContextObj context=CGLGetCurrentContext();
+  if(!context)
+    return false;
+  o_props[0]=CL_CONTEXT_PROPERTY_USE_CGL_SHAREGROUP_APPLE;
+  o_props[1]=(cl_context_properties)CGLGetShareGroup(context);
+  o_props[2]=0;
+#elif defined(_WIN32)
+  HGLRC context=wglGetCurrentContext();
+  if(!context)
+    return false;
+  o_props[0]=CL_GL_CONTEXT_KHR;
+  o_props[1]=(cl_context_properties)context;
+  o_props[2]=CL_WGL_HDC_KHR;
+  o_props[3]=(cl_context_properties)wglGetCurrentDC();
+  o_props[4]=CL_CONTEXT_PLATFORM;
+  o_props[5]=(cl_context_properties)_platform;
+  o_props[6]=0;
+#else
+  GLXContext context=glXGetCurrentContext();
+  if(!context)
+    return false;
+  o_props[0]=CL_GL_CONTEXT_KHR;
+  o_props[1]=(cl_context_properties)context;
+  o_props[2]=CL_GLX_DISPLAY_KHR;
+  o_props[3]=(cl_context_properties)glXGetCurrentDisplay();
+  o_props[4]=CL_CONTEXT_PLATFORM;
+  o_props[5]=(cl_context_properties)_platform;
+  o_props[6]=0;
+#endif
+  return true;
+}
+
+
+std::string OpenCL::s_deviceSelection;
+std::string OpenCL::s_deviceSplit;
+
+void OpenCL::setDeviceSelection(const std::string &_spec)
+{
+  s_deviceSelection=_spec;
+}
+
+void OpenCL::setDeviceSplit(const std::string &_spec)
+{
+  s_deviceSplit=_spec;
+}
+
+/// @brief lower case copy for the name matching
+static std::string lower(std::string _s)
+{
+  for(size_t i=0; i<_s.size(); ++i)
+    _s[i]=static_cast<char>(tolower(static_cast<unsigned char>(_s[i])));
+  return _s;
+}
+
+/// @brief a device with what it is matched on
+struct DeviceEntry
+{
+  cl_device_id m_device;
+  cl_uint m_platformIndex;
+  cl_uint m_deviceIndex;
+  cl_device_type m_type;
+  /// @brief platform vendor, platform name, device vendor and device name in lower case
+  std::string m_names;
+};
+
+/// @brief every device on every platform, indexed the same way as printCLInfo
+static std::vector<DeviceEntry> listDevices()
+{
+  std::vector<DeviceEntry> entries;
+  cl_uint platCount=0;
+  if(clGetPlatformIDs(0, NULL, &platCount) != CL_SUCCESS || platCount==0)
+    return entries;
+  std::vector<cl_platform_id> platforms(platCount);
+  clGetPlatformIDs(platCount, &platforms[0], NULL);
+  for(cl_uint p=0; p<platCount; ++p)
+  {
+    char platVendor[1024]={0};
+    char platName[1024]={0};
+    clGetPlatformInfo(platforms[p], CL_PLATFORM_VENDOR, sizeof(platVendor), platVendor, NULL);
+    clGetPlatformInfo(platforms[p], CL_PLATFORM_NAME, sizeof(platName), platName, NULL);
+    cl_uint devCount=0;
+    if(clGetDeviceIDs(platforms[p], CL_DEVICE_TYPE_ALL, 0, NULL, &devCount) != CL_SUCCESS || devCount==0)
+      continue;
+    std::vector<cl_device_id> devices(devCount);
+    clGetDeviceIDs(platforms[p], CL_DEVICE_TYPE_ALL, devCount, &devices[0], NULL);
+    for(cl_uint d=0; d<devCount; ++d)
+    {
+      DeviceEntry entry;
+      entry.m_device=devices[d];
+      entry.m_platformIndex=p;
+      entry.m_deviceIndex=d;
+      entry.m_type=0;
+      clGetDeviceInfo(devices[d], CL_DEVICE_TYPE, sizeof(entry.m_type), &entry.m_type, NULL);
+      char devVendor[1024]={0};
+      char devName[1024]={0};
+      clGetDeviceInfo(devices[d], CL_DEVICE_VENDOR, sizeof(devVendor), devVendor, NULL);
+      clGetDeviceInfo(devices[d], CL_DEVICE_NAME, sizeof(devName), devName, NULL);
+      entry.m_names=lower(std::string(platVendor)+" "+platName+" "+devVendor+" "+devName);
+      entries.push_back(entry);
+    }
+  }
+  return entries;
+}
+
+/// @brief the first device of the given type or 0
+static cl_device_id firstOfType(const std::vector<DeviceEntry> &_entries, cl_device_type _type)
+{
+  for(size_t i=0; i<_entries.size(); ++i)
+  {
+    if(_entries[i].m_type & _type)
+      return _entries[i].m_device;
+  }
+  return 0;
+}
+
+cl_device_id OpenCL::selectDevice(const std::string &_spec)
+{
+  std::vector<DeviceEntry> entries=listDevices();
+  if(entries.empty())
+    return 0;
+  std::string spec=_spec.empty() ? s_deviceSelection : _spec;
+  if(spec.empty())
+  {
+    const char *env=getenv("OPENCL_DEVICE");
+    spec = env ? env : "";
+  }
+  spec=lower(spec);
 
+  cl_device_id device=0;
+  if(!spec.empty() && spec!="default")
+  {
+    unsigned int platformIndex, deviceIndex;
+    char rest;
+    if(spec=="gpu")
+      device=firstOfType(entries,CL_DEVICE_TYPE_GPU);
+    else if(spec=="cpu")
+      device=firstOfType(entries,CL_DEVICE_TYPE_CPU);
+    else if(spec=="accelerator")
+      device=firstOfType(entries,CL_DEVICE_TYPE_ACCELERATOR);
+    else if(sscanf(spec.c_str(),"%u:%u%c",&platformIndex,&deviceIndex,&rest)==2)
+    {
+      for(size_t i=0; i<entries.size() && !device; ++i)
+      {
+        if(entries[i].m_platformIndex==platformIndex && entries[i].m_deviceIndex==deviceIndex)
+          device=entries[i].m_device;
+      }
+    }
+    else
+    {
+      for(size_t i=0; i<entries.size() && !device; ++i)
+      {
+        if(entries[i].m_names.find(spec)!=std::string::npos)
+          device=entries[i].m_device;
+      }
+    }
+    if(!device)
+      std::cerr<<"No OpenCL device matches \""<<spec<<"\", using the default choice\n";
+  }
+  // the default is a GPU if there is one then a CPU runtime (POCL etc) so the build farm can still run the kernels
+  if(!device)
+    device=firstOfType(entries,CL_DEVICE_TYPE_GPU);
+  if(!device)
+  {
+    device=firstOfType(entries,CL_DEVICE_TYPE_CPU);
+    if(device)
+      std::cerr<<"No OpenCL GPU found, falling back to a CPU device\n";
+  }
+  if(!device)
+    device=entries[0].m_device;
+  return device;
+}
+
+std::vector<std::string> OpenCL::splitDevices()
+{
+  std::string spec=s_deviceSplit;
+  if(spec.empty())
+  {
+    const char *env=getenv("OPENCL_DEVICES");
+    spec = env ? env : "";
+  }
+  spec=lower(spec);
+  std::vector<std::string> devices;
+  if(spec.empty())
+    return devices;
+  std::vector<DeviceEntry> entries=listDevices();
+  std::vector<cl_device_id> picked;
+  if(spec=="all")
+  {
+    for(size_t i=0; i<entries.size(); ++i)
+      picked.push_back(entries[i].m_device);
+  }
+  else
+  {
+    size_t start=0;
+    while(start<=spec.size())
+    {
+      size_t comma=spec.find(',',start);
+      if(comma==std::string::npos)
+        comma=spec.size();
+      std::string one=spec.substr(start,comma-start);
+      if(!one.empty())
+      {
+        cl_device_id device=selectDevice(one);
+        // two entries matching the same device would just fight over it
+        bool seen=false;
+        for(size_t i=0; i<picked.size(); ++i)
+          seen = seen || picked[i]==device;
+        if(device && !seen)
+          picked.push_back(device);
+      }
+      start=comma+1;
+    }
+  }
+  // as indices so each can be handed back to selectDevice
+  for(size_t p=0; p<picked.size(); ++p)
+  {
+    for(size_t i=0; i<entries.size(); ++i)
+    {
+      if(entries[i].m_device==picked[p])
+      {
+        char index[32];
+        sprintf(index,"%u:%u",entries[i].m_platformIndex,entries[i].m_deviceIndex);
+        devices.push_back(index);
+        break;
+      }
+    }
+  }
+  return devices;
+}
 
 OpenCL::OpenCL()
 {
@@ -15,11 +288,27 @@ OpenCL::OpenCL(std::string _kernel)
   loadKernelSource(_kernel);
 }
 
+OpenCL::OpenCL(std::string _kernel, bool _shareGL)
+{
+  initCL(_shareGL);
+  loadKernelSource(_kernel);
+}
+
+OpenCL::OpenCL(std::string _kernel, bool _shareGL, const std::string &_device)
+{
+  initCL(_shareGL,_device);
+  loadKernelSource(_kernel);
+}
+
 OpenCL::~OpenCL()
 {
-  clReleaseProgram(m_program);
-  clReleaseKernel(m_kernel);
+  // the program is only there once a source is loaded and the kernel if createKernel was used
+  if(m_kernel)
+    clReleaseKernel(m_kernel);
+  if(m_program)
+    clReleaseProgram(m_program);
   clReleaseCommandQueue(m_commands);
+  clReleaseCommandQueue(m_transfer);
   clReleaseContext(m_context);
 }
 
@@ -61,33 +350,44 @@ void OpenCL::printCLInfo()
 }
 
 
-void OpenCL::initCL()
+void OpenCL::initCL(bool _shareGL, const std::string &_device)
 {
-  int err;                            // error code returned from api calls
+  int err=CL_SUCCESS;                 // error code returned from api calls
+  m_program=0;
+  m_kernel=0;
 
-
-  // Connect to a compute device
-  cl_uint plat_count;
-  clGetPlatformIDs (0, NULL, &plat_count);
-  cl_platform_id *platforms =  new cl_platform_id [plat_count];
-  clGetPlatformIDs(plat_count, platforms, NULL);
-#ifdef LINUX
-  err = clGetDeviceIDs(platforms[0], CL_DEVICE_TYPE_GPU, 1, &m_deviceID, NULL);
-  std::cout<<"Device is "<<m_deviceID<<"\n";
-#else
-  // only going to connect to a GPU
-  err = clGetDeviceIDs(NULL, CL_DEVICE_TYPE_GPU , 1, &m_deviceID, NULL);
-#endif
-  if (err != CL_SUCCESS)
+  // Connect to a compute device, see selectDevice for how it is picked
+  m_deviceID = selectDevice(_device);
+  if (m_deviceID == 0)
   {
-      std::cerr<<"Error: Failed to create a device group!\n";
-      printError(err);
+      std::cerr<<"Error: no OpenCL devices found, install a GPU driver or a CPU runtime such as POCL\n";
       exit( EXIT_FAILURE);
   }
+  char name[1024];
+  clGetDeviceInfo(m_deviceID, CL_DEVICE_NAME, sizeof(name), name, NULL);
+  std::cerr<<"Device is "<<name<<"\n";
 
-  // Create a compute context
+  // Create a compute context, shared with GL if asked for and the device can do it. Sharing is only an
+  // optimisation so anything going wrong here just drops back to a normal context
   //
-  m_context = clCreateContext(0, 1, &m_deviceID, NULL, NULL, &err);
+  m_glShared=false;
+  m_context=0;
+  cl_context_properties props[7];
+  cl_platform_id platform;
+  clGetDeviceInfo(m_deviceID, CL_DEVICE_PLATFORM, sizeof(platform), &platform, NULL);
+  if(_shareGL && deviceCanShareGL(m_deviceID) && glContextProperties(platform,props))
+  {
+    m_context = clCreateContext(props, 1, &m_deviceID, NULL, NULL, &err);
+    m_glShared = (m_context!=0);
+  }
+  if(_shareGL)
+  {
+    std::cerr<<(m_glShared ? "Using CL/GL buffer sharing\n" : "CL/GL sharing not available, copying through the host\n");
+  }
+  if(!m_context)
+  {
+    m_context = clCreateContext(0, 1, &m_deviceID, NULL, NULL, &err);
+  }
   if (!m_context)
   {
       std::cerr<<"Error: Failed to create a compute context!\n";
@@ -95,34 +395,201 @@ void OpenCL::initCL()
       exit( EXIT_FAILURE);
   }
 
-  // Create a command commands
+  // Create a command commands, with profiling on both so every command's event carries its device timestamps
   //
-  m_commands = clCreateCommandQueue(m_context, m_deviceID, 0, &err);
+  m_commands = clCreateCommandQueue(m_context, m_deviceID, CL_QUEUE_PROFILING_ENABLE, &err);
   if (!m_commands)
   {
       std::cerr<<"Error: Failed to create a command commands!\n";
       printError(err);
       exit( EXIT_FAILURE);
   }
+  m_transfer = clCreateCommandQueue(m_context, m_deviceID, CL_QUEUE_PROFILING_ENABLE, &err);
+  if (!m_transfer)
+  {
+      std::cerr<<"Error: Failed to create the transfer queue!\n";
+      printError(err);
+      exit( EXIT_FAILURE);
+  }
 
 }
 
 
+/// @brief 64 bit FNV-1a, used for the binary cache key
+static uint64_t fnv1a(const std::string &_data, uint64_t _hash=14695981039346656037ULL)
+{
+  for(size_t i=0; i<_data.size(); ++i)
+  {
+    _hash^=static_cast<unsigned char>(_data[i]);
+    _hash*=1099511628211ULL;
+  }
+  return _hash;
+}
+
+/// @brief a device or platform info string
+static std::string deviceString(cl_device_id _device, cl_device_info _info)
+{
+  size_t size=0;
+  clGetDeviceInfo(_device, _info, 0, NULL, &size);
+  std::vector<char> value(size+1,0);
+  clGetDeviceInfo(_device, _info, size, &value[0], NULL);
+  return std::string(&value[0]);
+}
+
+/// @brief the header at the start of a cached binary, the key is checked again on load so a stale or foreign file
+/// is never handed to the driver
+struct BinaryHeader
+{
+  char m_magic[8];
+  uint64_t m_key;
+  uint64_t m_size;
+};
+static const char s_binaryMagic[8]={'C','L','B','I','N','0','0','1'};
+
+uint64_t OpenCL::deviceHash() const
+{
+  // anything that can change the compiled code, the driver version changes with every driver update
+  cl_platform_id platform;
+  clGetDeviceInfo(m_deviceID, CL_DEVICE_PLATFORM, sizeof(platform), &platform, NULL);
+  char platformVersion[1024]={0};
+  clGetPlatformInfo(platform, CL_PLATFORM_VERSION, sizeof(platformVersion), platformVersion, NULL);
+  uint64_t key=fnv1a(platformVersion);
+  key=fnv1a(deviceString(m_deviceID,CL_DEVICE_VENDOR),key);
+  key=fnv1a(deviceString(m_deviceID,CL_DEVICE_NAME),key);
+  key=fnv1a(deviceString(m_deviceID,CL_DEVICE_VERSION),key);
+  return fnv1a(deviceString(m_deviceID,CL_DRIVER_VERSION),key);
+}
+
+uint64_t OpenCL::binaryKey(const std::string &_source) const
+{
+  return fnv1a(_source,deviceHash());
+}
+
+std::string OpenCL::deviceKey() const
+{
+  char key[17];
+  sprintf(key,"%016llx",static_cast<unsigned long long>(deviceHash()));
+  return key;
+}
+
+std::string OpenCL::deviceName() const
+{
+  return deviceString(m_deviceID,CL_DEVICE_NAME);
+}
+
+std::string OpenCL::binaryPath(const std::string &_fname, uint64_t _key)
+{
+  if(getenv("OPENCL_NO_CACHE"))
+    return "";
+  std::string dir;
+  std::string name=_fname;
+  size_t slash=_fname.find_last_of("/\\");
+  if(slash!=std::string::npos)
+  {
+    dir=_fname.substr(0,slash+1);
+    name=_fname.substr(slash+1);
+  }
+  const char *cacheDir=getenv("OPENCL_CACHE_DIR");
+  if(cacheDir && *cacheDir)
+  {
+    dir=std::string(cacheDir)+"/";
+  }
+  char key[17];
+  sprintf(key,"%016llx",static_cast<unsigned long long>(_key));
+  return dir+name+"."+key+".bin";
+}
+
+bool OpenCL::loadBinary(const std::string &_path, uint64_t _key)
+{
+  std::ifstream file(_path.c_str(), std::ios::binary);
+  if(!file.is_open())
+    return false;
+  BinaryHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if(!file || memcmp(header.m_magic,s_binaryMagic,sizeof(s_binaryMagic))!=0 || header.m_key!=_key || header.m_size==0)
+    return false;
+  std::vector<unsigned char> binary(header.m_size);
+  file.read(reinterpret_cast<char *>(&binary[0]), header.m_size);
+  if(!file)
+    return false;
+
+  size_t size=binary.size();
+  const unsigned char *data=&binary[0];
+  cl_int status, err;
+  m_program = clCreateProgramWithBinary(m_context, 1, &m_deviceID, &size, &data, &status, &err);
+  if(!m_program || err != CL_SUCCESS || status != CL_SUCCESS)
+  {
+    if(m_program)
+      clReleaseProgram(m_program);
+    m_program = 0;
+    return false;
+  }
+  // a binary still has to be built, this is just the link so is quick
+  if(clBuildProgram(m_program, 0, NULL, NULL, NULL, NULL) != CL_SUCCESS)
+  {
+    clReleaseProgram(m_program);
+    m_program = 0;
+    return false;
+  }
+  return true;
+}
+
+void OpenCL::saveBinary(const std::string &_path, uint64_t _key) const
+{
+  size_t size=0;
+  if(clGetProgramInfo(m_program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, NULL) != CL_SUCCESS || size==0)
+    return;
+  std::vector<unsigned char> binary(size);
+  unsigned char *data=&binary[0];
+  if(clGetProgramInfo(m_program, CL_PROGRAM_BINARIES, sizeof(data), &data, NULL) != CL_SUCCESS)
+    return;
+  BinaryHeader header;
+  memcpy(header.m_magic,s_binaryMagic,sizeof(s_binaryMagic));
+  header.m_key=_key;
+  header.m_size=size;
+  // written to one side and renamed so another process never loads half a file
+  std::string temp=_path+".tmp";
+  {
+    std::ofstream file(temp.c_str(), std::ios::binary);
+    if(!file.is_open())
+      return;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(&binary[0]), size);
+    if(!file)
+    {
+      file.close();
+      remove(temp.c_str());
+      return;
+    }
+  }
+  if(rename(temp.c_str(), _path.c_str())!=0)
+  {
+    remove(temp.c_str());
+  }
+}
+
 void OpenCL::loadKernelSource(const std::string &_fname)
 {
   std::ifstream kernelSource(_fname.c_str());
-  std::string *source;
   if (!kernelSource.is_open())
   {
    std::cerr<<"File not found "<<_fname.c_str()<<"\n";
    exit(EXIT_FAILURE);
   }
   // now read in the data
-  source = new std::string((std::istreambuf_iterator<char>(kernelSource)), std::istreambuf_iterator<char>());
+  std::string source((std::istreambuf_iterator<char>(kernelSource)), std::istreambuf_iterator<char>());
   kernelSource.close();
-  *source+="\0";
 
-  const char* data=source->c_str();
+  // use the binary from an earlier run if this device, driver and source have been built before
+  uint64_t key=binaryKey(source);
+  std::string cache=binaryPath(_fname,key);
+  if(!cache.empty() && loadBinary(cache,key))
+  {
+    std::cerr<<"Using the cached program "<<cache<<"\n";
+    return;
+  }
+
+  const char* data=source.c_str();
   int err;                            // error code returned from api calls
 
   m_program = clCreateProgramWithSource(m_context, 1, (const char **) & data, NULL, &err);
@@ -132,7 +599,6 @@ void OpenCL::loadKernelSource(const std::string &_fname)
       printError(err);
       exit (EXIT_FAILURE);
   }
-  delete source;
 
   // Build the program executable
   //
@@ -154,6 +620,10 @@ void OpenCL::loadKernelSource(const std::string &_fname)
     delete [] log;
     exit(EXIT_FAILURE);
   }
+  if(!cache.empty())
+  {
+    saveBinary(cache,key);
+  }
 }
 
 void OpenCL::createKernel(const std::string &_name)
@@ -0,0 +1,459 @@
+#include "ParticleKernel.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+const char *ParticleKernel::layoutName(Layout _layout)
+{
+	switch(_layout)
+	{
+		case SOA4 : return "SoA float4";
+		case SOA8 : return "SoA float8";
+		default : return "AoS";
+	}
+}
+
+ParticleKernel::ParticleKernel(OpenCL *_cl, sim::CLHostSystem *_particles, Layout _layout) :
+	m_cl(_cl), m_particles(_particles), m_numParticles(_particles->size()), m_first(0), m_count(_particles->size()), m_layout(_layout), m_shared(false), m_frame(0)
+{
+	for(int i=0; i<s_buffers; ++i)
+	{
+		m_output[i] = clCreateBuffer(m_cl->getContext(), CL_MEM_WRITE_ONLY, sizeof(sim::GLParticle) * m_numParticles, NULL, NULL);
+	}
+	init();
+}
+
+ParticleKernel::ParticleKernel(OpenCL *_cl, sim::CLHostSystem *_particles, const cl_GLuint _vbos[s_buffers], Layout _layout) :
+	m_cl(_cl), m_particles(_particles), m_numParticles(_particles->size()), m_first(0), m_count(_particles->size()), m_layout(_layout), m_shared(false), m_frame(0)
+{
+	for(int i=0; i<s_buffers; ++i)
+	{
+		m_output[i] = 0;
+	}
+	if(m_cl->isGLShared())
+	{
+		m_shared=true;
+		for(int i=0; i<s_buffers && m_shared; ++i)
+		{
+			int err;
+			m_output[i] = clCreateFromGLBuffer(m_cl->getContext(), CL_MEM_WRITE_ONLY, _vbos[i], &err);
+			if(err != CL_SUCCESS)
+			{
+				m_cl->printError(err);
+				m_output[i] = 0;
+				m_shared = false;
+			}
+		}
+	}
+	if(!m_shared)
+	{
+		std::cerr<<"Unable to share the vertex buffers, reading the positions back instead\n";
+		for(int i=0; i<s_buffers; ++i)
+		{
+			if(m_output[i])
+			{
+				clReleaseMemObject(m_output[i]);
+			}
+			m_output[i] = clCreateBuffer(m_cl->getContext(), CL_MEM_WRITE_ONLY, sizeof(sim::GLParticle) * m_numParticles, NULL, NULL);
+		}
+	}
+	init();
+}
+
+void ParticleKernel::init()
+{
+	for(int i=0; i<s_buffers; ++i)
+	{
+		m_done[i] = 0;
+		m_numEvents[i] = 0;
+		m_eventFrame[i] = 0;
+	}
+	m_profile.m_frame = 0;
+	m_profile.m_numCommands = 0;
+	m_upload.m_frame = 0;
+	m_upload.m_numCommands = 0;
+	for(int i=0; i<4; ++i)
+	{
+		m_input[i] = 0;
+	}
+	const char *names[]={"updateparticle","updateparticle_soa4","updateparticle_soa8"};
+	const size_t widths[]={1,4,8};
+	m_width = widths[m_layout];
+	int err;
+	m_kernel = clCreateKernel(m_cl->getProgram(), names[m_layout], &err);
+	if (!m_kernel || err != CL_SUCCESS)
+	{
+		std::cerr<<"Error: Failed to create the "<<names[m_layout]<<" kernel!\n";
+		m_cl->printError(err);
+		exit(EXIT_FAILURE);
+	}
+
+	bool allocated = m_output[0] && m_output[1];
+	cl_event upload[4];
+	if(m_layout == AOS)
+	{
+		m_input[0] = clCreateBuffer(m_cl->getContext(),  CL_MEM_READ_WRITE,  sizeof(sim::CLParticle) * m_numParticles, NULL, NULL);
+		allocated = allocated && m_input[0];
+		// the only time the particles go to the device, the kernel keeps them up to date from here on
+		if(allocated)
+		{
+			err = clEnqueueWriteBuffer(m_cl->getCommands(), m_input[0], CL_TRUE, 0, sizeof(sim::CLParticle) * m_numParticles, m_particles->particles(), 0, NULL, &upload[0]);
+			m_upload.m_numCommands = err == CL_SUCCESS ? 1 : 0;
+		}
+	}
+	else
+	{
+		// split into the four arrays, padded with still particles so every work item can load a whole vector
+		size_t padded = (m_numParticles+m_width-1)/m_width*m_width;
+		std::vector<float> arrays[4];
+		for(int a=0; a<4; ++a)
+		{
+			arrays[a].assign(padded,0.0f);
+		}
+		const sim::CLParticle *particles = m_particles->particles();
+		for(size_t i=0; i<m_numParticles; ++i)
+		{
+			arrays[0][i] = particles[i].m_dx;
+			arrays[1][i] = particles[i].m_dy;
+			arrays[2][i] = particles[i].m_dz;
+			arrays[3][i] = particles[i].m_currentLife;
+		}
+		err = CL_SUCCESS;
+		for(int a=0; a<4 && allocated; ++a)
+		{
+			m_input[a] = clCreateBuffer(m_cl->getContext(), CL_MEM_READ_WRITE, sizeof(float) * padded, NULL, NULL);
+			allocated = m_input[a] != 0;
+			if(allocated)
+			{
+				int written = clEnqueueWriteBuffer(m_cl->getCommands(), m_input[a], CL_TRUE, 0, sizeof(float) * padded, &arrays[a][0], 0, NULL, &upload[m_upload.m_numCommands]);
+				if(written == CL_SUCCESS)
+				{
+					++m_upload.m_numCommands;
+				}
+				err |= written;
+			}
+		}
+	}
+	for(int i=0; i<m_upload.m_numCommands; ++i)
+	{
+		readTimes(upload[i],"write",m_upload.m_commands[i]);
+		clReleaseEvent(upload[i]);
+	}
+	if (!allocated)
+	{
+		std::cerr<<"Error: Failed to allocate device memory!\n";
+		exit(EXIT_FAILURE);
+	}
+	if (err != CL_SUCCESS)
+	{
+		std::cerr<<"Error: Failed to write to source array!\n";
+		exit(EXIT_FAILURE);
+	}
+
+	// Get the maximum work group size for executing the kernel on the device
+	//
+	err = clGetKernelWorkGroupInfo(m_kernel, m_cl->getID(), CL_KERNEL_WORK_GROUP_SIZE, sizeof(m_workgroupsize), &m_workgroupsize, NULL);
+	std::cerr<<layoutName(m_layout)<<" kernel work group size is "<<m_workgroupsize<<"\n";
+	if (err != CL_SUCCESS)
+	{
+		std::cerr<<"Error: Failed to retrieve kernel work group info "<<err<<"\n";
+		exit(EXIT_FAILURE);
+	}
+	setLaunch(m_workgroupsize,1);
+}
+
+void ParticleKernel::setLaunch(size_t _local, size_t _perItem)
+{
+	m_local = _local < m_workgroupsize ? _local : m_workgroupsize;
+	m_perItem = _perItem > 0 ? _perItem : 1;
+	// a whole number of groups, the kernels skip anything past the last particle so this never has to divide the
+	// particle count
+	size_t vectors = (m_count+m_width-1)/m_width;
+	size_t items = (vectors+m_perItem-1)/m_perItem;
+	m_globalSize = m_local ? (items+m_local-1)/m_local*m_local : items;
+}
+
+ParticleKernel::~ParticleKernel()
+{
+	finish();
+	for(int i=0; i<4; ++i)
+	{
+		if(m_input[i])
+		{
+			clReleaseMemObject(m_input[i]);
+		}
+	}
+	for(int i=0; i<s_buffers; ++i)
+	{
+		clReleaseMemObject(m_output[i]);
+	}
+	clReleaseKernel(m_kernel);
+}
+
+void ParticleKernel::setRange(size_t _first, size_t _count)
+{
+	m_first = _first;
+	m_count = _count;
+	setLaunch(m_local,m_perItem);
+}
+
+void ParticleKernel::copyParticles(const ParticleKernel &_from, size_t _first, size_t _count)
+{
+	if(_count == 0)
+	{
+		return;
+	}
+	// through the host as the kernels can be in different contexts, only the moved particles go across
+	int err = CL_SUCCESS;
+	if(m_layout == AOS)
+	{
+		std::vector<sim::CLParticle> particles(_count);
+		size_t offset = sizeof(sim::CLParticle) * _first;
+		size_t bytes = sizeof(sim::CLParticle) * _count;
+		err |= clEnqueueReadBuffer(_from.m_cl->getCommands(), _from.m_input[0], CL_TRUE, offset, bytes, &particles[0], 0, NULL, NULL);
+		err |= clEnqueueWriteBuffer(m_cl->getCommands(), m_input[0], CL_TRUE, offset, bytes, &particles[0], 0, NULL, NULL);
+	}
+	else
+	{
+		std::vector<float> values(_count);
+		size_t offset = sizeof(float) * _first;
+		size_t bytes = sizeof(float) * _count;
+		for(int a=0; a<4; ++a)
+		{
+			err |= clEnqueueReadBuffer(_from.m_cl->getCommands(), _from.m_input[a], CL_TRUE, offset, bytes, &values[0], 0, NULL, NULL);
+			err |= clEnqueueWriteBuffer(m_cl->getCommands(), m_input[a], CL_TRUE, offset, bytes, &values[0], 0, NULL, NULL);
+		}
+	}
+	if (err != CL_SUCCESS)
+	{
+		std::cerr<<"Error: Failed to copy particles between devices\n";
+		exit(EXIT_FAILURE);
+	}
+}
+
+void ParticleKernel::enqueue(const sim::Vec3 &_wind, const sim::Vec3 &_end, cl_uint _numWait, const cl_event *_wait, cl_event *o_done)
+{
+	// Set the arguments to our compute kernel, the host side here overlaps whatever the device is still doing
+	//
+	sim::Vec3 pos=m_particles->position();
+	float gravity=-9.0f;
+	float step=m_particles->step();
+	cl_uint seedLo=static_cast<cl_uint>(m_particles->seed());
+	cl_uint seedHi=static_cast<cl_uint>(m_particles->seed()>>32);
+	cl_uint first=static_cast<cl_uint>(m_first);
+	cl_uint last=static_cast<cl_uint>(m_first+m_count);
+	int err = 0;
+	// the particle buffers come first, then the output and the frame's values in the same order for every layout
+	cl_uint arg=0;
+	int numInputs = m_layout==AOS ? 1 : 4;
+	for(int i=0; i<numInputs; ++i)
+	{
+		err |= clSetKernelArg(m_kernel, arg++, sizeof(cl_mem), &m_input[i]);
+	}
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(cl_mem), &m_output[slot()]);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(sim::Vec3), &_wind);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(sim::Vec3), &pos);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(float), &gravity);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(sim::Vec3), &_end);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(float), &step);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(cl_uint), &seedLo);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(cl_uint), &seedHi);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(cl_uint), &m_frame);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(cl_uint), &first);
+	err |= clSetKernelArg(m_kernel, arg++, sizeof(cl_uint), &last);
+	if (err != CL_SUCCESS)
+	{
+		std::cerr<<"Error: Failed to set kernel arguments! "<< err<<"\n";
+		exit(EXIT_FAILURE);
+	}
+
+	// Execute the kernel over the entire range of our 1d input data set
+	// using the launch shape from setLaunch
+	//
+	err = clEnqueueNDRangeKernel(m_cl->getCommands(), m_kernel, 1, NULL, &m_globalSize, m_local ? &m_local : NULL, _numWait, _wait, o_done);
+	if (err)
+	{
+		m_cl->printError(err);
+		std::cerr<<"Error: Failed to execute kernel!\n";
+		exit( EXIT_FAILURE);
+	}
+}
+
+void ParticleKernel::wait(int _slot)
+{
+	if(m_done[_slot])
+	{
+		clWaitForEvents(1, &m_done[_slot]);
+		clReleaseEvent(m_done[_slot]);
+		m_done[_slot] = 0;
+	}
+	// everything in the slot finished before its last command so the timestamps are all there now
+	if(m_numEvents[_slot])
+	{
+		m_profile.m_frame = m_eventFrame[_slot];
+		m_profile.m_numCommands = m_numEvents[_slot];
+		for(int i=0; i<m_numEvents[_slot]; ++i)
+		{
+			readTimes(m_events[_slot][i], m_eventNames[_slot][i], m_profile.m_commands[i]);
+			clReleaseEvent(m_events[_slot][i]);
+		}
+		m_numEvents[_slot] = 0;
+	}
+}
+
+void ParticleKernel::record(int _slot, const char *_name, cl_event _event)
+{
+	if(m_numEvents[_slot] < s_maxCommands)
+	{
+		m_events[_slot][m_numEvents[_slot]] = _event;
+		m_eventNames[_slot][m_numEvents[_slot]] = _name;
+		++m_numEvents[_slot];
+	}
+	else
+	{
+		clReleaseEvent(_event);
+	}
+}
+
+void ParticleKernel::readTimes(cl_event _event, const char *_name, Command &o_command)
+{
+	o_command.m_name = _name;
+	const cl_profiling_info info[]={CL_PROFILING_COMMAND_QUEUED,CL_PROFILING_COMMAND_SUBMIT,CL_PROFILING_COMMAND_START,CL_PROFILING_COMMAND_END};
+	cl_ulong *times[]={&o_command.m_queued,&o_command.m_submit,&o_command.m_start,&o_command.m_end};
+	for(int i=0; i<4; ++i)
+	{
+		// CL_PROFILING_INFO_NOT_AVAILABLE if the queue wasn't made with profiling
+		if(clGetEventProfilingInfo(_event, info[i], sizeof(cl_ulong), times[i], NULL) != CL_SUCCESS)
+		{
+			*times[i] = 0;
+		}
+	}
+}
+
+bool ParticleKernel::Command::isTransfer() const
+{
+	return strcmp(m_name,"kernel") != 0;
+}
+
+double ParticleKernel::Profile::compute() const
+{
+	cl_ulong ns=0;
+	for(int i=0; i<m_numCommands; ++i)
+	{
+		if(!m_commands[i].isTransfer())
+			ns += m_commands[i].m_end-m_commands[i].m_start;
+	}
+	return ns/1.0e6;
+}
+
+double ParticleKernel::Profile::transfer() const
+{
+	cl_ulong ns=0;
+	for(int i=0; i<m_numCommands; ++i)
+	{
+		if(m_commands[i].isTransfer())
+			ns += m_commands[i].m_end-m_commands[i].m_start;
+	}
+	return ns/1.0e6;
+}
+
+double ParticleKernel::Profile::span() const
+{
+	if(m_numCommands == 0)
+		return 0.0;
+	cl_ulong first=m_commands[0].m_start;
+	cl_ulong last=m_commands[0].m_end;
+	for(int i=1; i<m_numCommands; ++i)
+	{
+		first = m_commands[i].m_start < first ? m_commands[i].m_start : first;
+		last = m_commands[i].m_end > last ? m_commands[i].m_end : last;
+	}
+	return (last-first)/1.0e6;
+}
+
+void ParticleKernel::update(const sim::Vec3 &_wind, sim::GLParticle *o_positions)
+{
+	submit(_wind, m_particles->nextDirection(), o_positions);
+	// hand back the previous frame, this frame carries on while the caller draws that one
+	complete();
+}
+
+void ParticleKernel::submit(const sim::Vec3 &_wind, const sim::Vec3 &_end, sim::GLParticle *o_positions)
+{
+	int current=slot();
+	m_eventFrame[current]=m_frame;
+	// the kernel overwrites this slot's buffer so has to wait for the read from two frames ago, it is already behind
+	// the previous kernel on the in order compute queue so the particles are up to date
+	cl_event kernelDone;
+	enqueue(_wind, _end, m_done[current] ? 1 : 0, m_done[current] ? &m_done[current] : NULL, &kernelDone);
+	if(m_done[current])
+	{
+		clReleaseEvent(m_done[current]);
+	}
+	// only the positions in the range leave the device, on the transfer queue so the next kernel doesn't queue up
+	// behind it
+	//
+	int err = clEnqueueReadBuffer( m_cl->getTransfer(), m_output[current], CL_FALSE, sizeof(sim::GLParticle) * m_first, sizeof(sim::GLParticle) * m_count, o_positions+m_first, 1, &kernelDone, &m_done[current] );
+	if (err != CL_SUCCESS)
+	{
+		std::cerr<<"Error: Failed to read output array "<< err<<"\n";
+		exit(EXIT_FAILURE);
+	}
+	// the events are kept for the profile until the frame is complete
+	record(current, "kernel", kernelDone);
+	clRetainEvent(m_done[current]);
+	record(current, "read", m_done[current]);
+	clFlush(m_cl->getCommands());
+	clFlush(m_cl->getTransfer());
+	++m_frame;
+}
+
+void ParticleKernel::update(const sim::Vec3 &_wind)
+{
+	if(!m_shared)
+	{
+		std::cerr<<"Error: the positions aren't in a GL buffer, use update(wind,positions)\n";
+		exit(EXIT_FAILURE);
+	}
+	int current=slot();
+	m_eventFrame[current]=m_frame;
+	// the buffer belongs to CL between the acquire and release, nothing is copied. The compute queue is in order so
+	// only the release is waited on, the other events are just for the profile
+	cl_event acquired;
+	int err = clEnqueueAcquireGLObjects(m_cl->getCommands(), 1, &m_output[current], 0, NULL, &acquired);
+	if (err != CL_SUCCESS)
+	{
+		m_cl->printError(err);
+		std::cerr<<"Error: Failed to acquire the vertex buffer\n";
+		exit(EXIT_FAILURE);
+	}
+	record(current, "acquire", acquired);
+	cl_event kernelDone;
+	enqueue(_wind, m_particles->nextDirection(), 0, NULL, &kernelDone);
+	record(current, "kernel", kernelDone);
+	err = clEnqueueReleaseGLObjects(m_cl->getCommands(), 1, &m_output[current], 0, NULL, &m_done[current]);
+	if (err != CL_SUCCESS)
+	{
+		m_cl->printError(err);
+		std::cerr<<"Error: Failed to release the vertex buffer\n";
+		exit(EXIT_FAILURE);
+	}
+	clRetainEvent(m_done[current]);
+	record(current, "release", m_done[current]);
+	clFlush(m_cl->getCommands());
+	++m_frame;
+	// without cl_khr_gl_event waiting on the release is the only portable way to know GL can draw the buffer, this
+	// is the previous frame so it has had the whole of the last frame to finish
+	wait(slot());
+}
+
+void ParticleKernel::finish()
+{
+	for(int i=0; i<s_buffers; ++i)
+	{
+		wait(i);
+	}
+	clFinish(m_cl->getCommands());
+	clFinish(m_cl->getTransfer());
+}
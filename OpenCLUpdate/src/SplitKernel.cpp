@@ -0,0 +1,171 @@
+#include "SplitKernel.h"
+#include <cstdlib>
+#include <iostream>
+
+/// @brief how much each frame's rate counts against the ones before, the device times jitter from frame to frame
+static const double s_smoothing=0.25;
+/// @brief the ranges only move when a device is this far (as a fraction of all the particles) from its share,
+/// moving drains the pipeline so it isn't done for noise
+static const double s_threshold=0.02;
+/// @brief every device keeps at least this share so it is still timed and can pick work back up
+static const double s_minShare=1.0/64.0;
+
+SplitKernel::SplitKernel(const std::vector<OpenCL *> &_cls, sim::CLHostSystem *_particles, ParticleKernel::Layout _layout,
+												 const std::vector<double> &_speeds) :
+	m_particles(_particles), m_layout(_layout), m_frame(0), m_settled(0), m_moves(0)
+{
+	if(_particles->size() < _cls.size()*ParticleKernel::s_rangeAlignment)
+	{
+		std::cerr<<"Error: too few particles to split across "<<_cls.size()<<" devices\n";
+		exit(EXIT_FAILURE);
+	}
+	// the even split unless every device has a speed
+	m_rates.assign(_cls.size(),1.0);
+	bool known = _speeds.size() == _cls.size();
+	for(size_t i=0; i<_speeds.size(); ++i)
+	{
+		known = known && _speeds[i] > 0.0;
+	}
+	std::vector<size_t> firsts;
+	split(known ? _speeds : m_rates,firsts);
+	for(size_t i=0; i<_cls.size(); ++i)
+	{
+		m_kernels.push_back(new ParticleKernel(_cls[i],_particles,_layout));
+		m_kernels[i]->setRange(firsts[i],firsts[i+1]-firsts[i]);
+		m_rates[i]=0.0;
+	}
+}
+
+SplitKernel::~SplitKernel()
+{
+	for(size_t i=0; i<m_kernels.size(); ++i)
+	{
+		delete m_kernels[i];
+	}
+}
+
+void SplitKernel::update(const sim::Vec3 &_wind, sim::GLParticle *o_positions)
+{
+	// one emit direction for the frame, and everything queued before any device is waited on so none sit idle
+	sim::Vec3 end=m_particles->nextDirection();
+	for(size_t i=0; i<m_kernels.size(); ++i)
+	{
+		m_kernels[i]->submit(_wind,end,o_positions);
+	}
+	++m_frame;
+	for(size_t i=0; i<m_kernels.size(); ++i)
+	{
+		m_kernels[i]->complete();
+	}
+	balance();
+}
+
+void SplitKernel::finish()
+{
+	for(size_t i=0; i<m_kernels.size(); ++i)
+	{
+		m_kernels[i]->finish();
+	}
+}
+
+void SplitKernel::balance()
+{
+	if(m_kernels.size() < 2)
+	{
+		return;
+	}
+	for(size_t i=0; i<m_kernels.size(); ++i)
+	{
+		const ParticleKernel::Profile &profile=m_kernels[i]->profile();
+		double ms=profile.compute()+profile.transfer();
+		// nothing complete on these ranges yet, or no timestamps from the device
+		if(profile.m_numCommands == 0 || profile.m_frame < m_settled || ms <= 0.0)
+		{
+			return;
+		}
+	}
+	for(size_t i=0; i<m_kernels.size(); ++i)
+	{
+		const ParticleKernel::Profile &profile=m_kernels[i]->profile();
+		double rate=m_kernels[i]->count()/(profile.compute()+profile.transfer());
+		m_rates[i] = m_rates[i] > 0.0 ? m_rates[i]+s_smoothing*(rate-m_rates[i]) : rate;
+	}
+	std::vector<size_t> firsts;
+	split(m_rates,firsts);
+	size_t furthest=0;
+	for(size_t i=0; i<m_kernels.size(); ++i)
+	{
+		size_t count=firsts[i+1]-firsts[i];
+		size_t current=m_kernels[i]->count();
+		size_t off = count > current ? count-current : current-count;
+		furthest = off > furthest ? off : furthest;
+	}
+	if(furthest > s_threshold*m_particles->size())
+	{
+		moveTo(firsts);
+	}
+}
+
+void SplitKernel::split(const std::vector<double> &_rates, std::vector<size_t> &o_firsts) const
+{
+	const size_t align=ParticleKernel::s_rangeAlignment;
+	size_t numParticles=m_particles->size();
+	size_t numDevices=_rates.size();
+	size_t minimum=static_cast<size_t>(numParticles*s_minShare)/align*align;
+	minimum = minimum > align ? minimum : align;
+	double total=0.0;
+	for(size_t i=0; i<numDevices; ++i)
+	{
+		total+=_rates[i];
+	}
+	o_firsts.assign(numDevices+1,0);
+	o_firsts[numDevices]=numParticles;
+	double share=0.0;
+	for(size_t i=1; i<numDevices; ++i)
+	{
+		share+=_rates[i-1]/total;
+		size_t first=static_cast<size_t>(share*numParticles+0.5)/align*align;
+		// room for the minimum before and after, the ones after may have a bigger share but this keeps them all alive
+		size_t lowest=o_firsts[i-1]+minimum;
+		size_t highest=numParticles-(numDevices-i)*minimum;
+		if(highest < lowest)
+		{
+			highest = lowest;
+		}
+		first = first < lowest ? lowest : first;
+		first = first > highest ? highest/align*align : first;
+		o_firsts[i]=first;
+	}
+}
+
+void SplitKernel::moveTo(const std::vector<size_t> &_firsts)
+{
+	// the frame in flight finishes on the old ranges, after that every device's particles are complete
+	finish();
+	for(size_t to=0; to<m_kernels.size(); ++to)
+	{
+		size_t newFirst=_firsts[to];
+		size_t newLast=_firsts[to+1];
+		for(size_t from=0; from<m_kernels.size(); ++from)
+		{
+			if(from == to)
+			{
+				continue;
+			}
+			size_t oldFirst=m_kernels[from]->first();
+			size_t oldLast=oldFirst+m_kernels[from]->count();
+			size_t first = newFirst > oldFirst ? newFirst : oldFirst;
+			size_t last = newLast < oldLast ? newLast : oldLast;
+			if(first < last)
+			{
+				m_kernels[to]->copyParticles(*m_kernels[from],first,last-first);
+			}
+		}
+	}
+	for(size_t i=0; i<m_kernels.size(); ++i)
+	{
+		m_kernels[i]->setRange(_firsts[i],_firsts[i+1]-_firsts[i]);
+	}
+	m_settled=m_frame;
+	++m_moves;
+}
@@ -3,13 +3,24 @@ basic OpenGL demo modified from http://qt-project.org/doc/qt-5.0/qtgui/openglwin
 ****************************************************************************/
 #include <QtGui/QGuiApplication>
 #include <iostream>
+#include <string>
 #include "NGLScene.h"
+#include "OpenCL.h"
 
 
 
 int main(int argc, char **argv)
 {
   QGuiApplication app(argc, argv);
+  // --cl-device gpu|cpu|platform:device|vendor picks the OpenCL device, OPENCL_DEVICE does the same
+  // --cl-devices all|gpu,cpu,... splits the particles across several, OPENCL_DEVICES does the same
+  for(int i=1; i<argc-1; ++i)
+  {
+    if(std::string(argv[i])=="--cl-device")
+      OpenCL::setDeviceSelection(argv[i+1]);
+    else if(std::string(argv[i])=="--cl-devices")
+      OpenCL::setDeviceSplit(argv[i+1]);
+  }
   // create an OpenGL format specifier
   QSurfaceFormat format;
   // set the number of samples for multisampling
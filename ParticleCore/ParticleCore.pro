@@ -0,0 +1,29 @@
+# the particle state and update loops shared by all the demos, there is no Qt, NGL or GL in here
+# so it can be used for batch runs and the benchmark as well as the demos
+TARGET=ParticleCore
+TEMPLATE=lib
+CONFIG+=staticlib c++11
+CONFIG-=qt
+# where to put the .o files
+OBJECTS_DIR=obj
+# the demos link against lib/libParticleCore.a
+DESTDIR=./lib
+# Auto include all .cpp files in the project src directory (can specifiy individually if required)
+SOURCES+= $$PWD/src/*.cpp
+# same for the .h files
+HEADERS+= $$PWD/include/sim/*.h
+INCLUDEPATH +=./include
+OTHER_FILES+= README.md \
+							UseParticleCore.pri
+# basic compiler flags (not all appropriate for all platforms)
+QMAKE_CXXFLAGS+= -msse -msse2 -msse3
+macx:QMAKE_CXXFLAGS+= -arch x86_64
+# no -march=native here, the SSE4 / AVX2 / AVX-512 kernels are picked at run time (see sim/Simd.h) so the library
+# runs on any node. No FMA contraction either so every kernel gives bit identical results
+!win32:QMAKE_CXXFLAGS+= -ffp-contract=off
+# now if we are under unix and not on a Mac (i.e. linux)
+linux-*{
+		QMAKE_CXXFLAGS +=  -pthread
+		DEFINES += LINUX
+}
+macx:DEFINES += DARWIN
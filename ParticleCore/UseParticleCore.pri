@@ -0,0 +1,8 @@
+# include this from a demo .pro to use the shared simulation code
+# it adds the include path and links lib/libParticleCore.a (build ParticleCore first)
+INCLUDEPATH+=$$PWD/include
+LIBS+= -L$$PWD/lib -lParticleCore
+unix:PRE_TARGETDEPS+=$$PWD/lib/libParticleCore.a
+win32:PRE_TARGETDEPS+=$$PWD/lib/ParticleCore.lib
+# the ThreadPool uses std::thread so the link needs pthreads on linux
+linux-*:QMAKE_LFLAGS += -pthread
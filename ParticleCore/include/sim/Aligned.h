@@ -0,0 +1,51 @@
+#ifndef SIM_ALIGNED_H__
+#define SIM_ALIGNED_H__
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+  #include <malloc.h>
+#endif
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Aligned.h
+/// @brief aligned allocation for the particle streams, C++11 has no portable aligned new so wrap the platform calls
+//----------------------------------------------------------------------------------------------------------------------
+/// @brief the default alignment, a cache line which also covers AVX-512 loads
+static const size_t s_cacheLine=64;
+
+/// @brief allocate _bytes aligned to _alignment, throws std::bad_alloc on failure like new
+/// @param _bytes the number of bytes to allocate
+/// @param _alignment a power of two which is a multiple of sizeof(void *)
+inline void *alignedAlloc(size_t _bytes, size_t _alignment=s_cacheLine)
+{
+  void *ptr=0;
+  // posix_memalign may return 0 for a zero size request, always ask for something so free is consistent
+  if(_bytes==0)
+    _bytes=_alignment;
+#ifdef _WIN32
+  ptr=_aligned_malloc(_bytes,_alignment);
+#else
+  if(posix_memalign(&ptr,_alignment,_bytes)!=0)
+    ptr=0;
+#endif
+  if(ptr==0)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+/// @brief free memory from alignedAlloc, null is ignored
+inline void alignedFree(void *_ptr)
+{
+#ifdef _WIN32
+  _aligned_free(_ptr);
+#else
+  free(_ptr);
+#endif
+}
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SIM_BLOCKEDSTORE_H__
+#define SIM_BLOCKEDSTORE_H__
+#include <cstddef>
+#include "sim/Aligned.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class BlockedStore
+/// @brief the particles as an array of structures of arrays (AoSoA). Particles are grouped into packets of Width
+/// and inside a packet each attribute is contiguous, so a packet attribute is one SIMD register wide while the
+/// whole particle is still in the same few cache lines. That keeps one prefetch stream going however many
+/// attributes are added, where the ParticleStore needs one per attribute.
+/// @param T the type of each attribute, normally float
+/// @param Width the particles per packet, 8 for AVX or 16 for AVX-512
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T, size_t Width>
+class BlockedStore
+{
+public :
+	typedef T value_type;
+	static const size_t s_width=Width;
+	/// @brief one packet of Width particles
+	struct Packet
+	{
+		T px[Width];
+		T py[Width];
+		T pz[Width];
+		T dx[Width];
+		T dy[Width];
+		T dz[Width];
+		T life[Width];
+	};
+
+	/// @brief ctor
+	/// @param _numParticles the number of particles to allocate, rounded up to whole packets. The values are not
+	/// initialised
+	explicit BlockedStore(size_t _numParticles=0) : m_numParticles(0), m_numPackets(0), m_packets(0)
+	{
+		resize(_numParticles);
+	}
+	/// @brief dtor frees the packets
+	~BlockedStore(){alignedFree(m_packets);}
+	/// @brief re-allocate for _numParticles, any existing values are lost
+	void resize(size_t _numParticles)
+	{
+		alignedFree(m_packets);
+		m_packets=0;
+		m_numParticles=0;
+		m_numPackets=0;
+		size_t numPackets=(_numParticles+Width-1)/Width;
+		m_packets=static_cast<Packet *>(alignedAlloc(sizeof(Packet)*numPackets,s_cacheLine));
+		m_numParticles=_numParticles;
+		m_numPackets=numPackets;
+	}
+	/// @brief the number of particles, the last packet may only be partly used
+	inline size_t size() const {return m_numParticles;}
+	inline size_t numPackets() const {return m_numPackets;}
+	inline Packet &packet(size_t _p){return m_packets[_p];}
+	inline const Packet &packet(size_t _p) const {return m_packets[_p];}
+	/// @brief the packet holding particle _i, use lane(_i) to index its attributes
+	inline Packet &packetOf(size_t _i){return m_packets[_i/Width];}
+	inline const Packet &packetOf(size_t _i) const {return m_packets[_i/Width];}
+	static inline size_t lane(size_t _i){return _i%Width;}
+
+private :
+	/// @brief the number of particles
+	size_t m_numParticles;
+	/// @brief the number of packets allocated
+	size_t m_numPackets;
+	/// @brief the packets
+	Packet *m_packets;
+	// the packets are owned so no copies
+	BlockedStore(const BlockedStore &);
+	BlockedStore &operator=(const BlockedStore &);
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef SIM_CLHOSTSYSTEM_H__
+#define SIM_CLHOSTSYSTEM_H__
+#include <cstddef>
+#include <stdint.h>
+#include "sim/Particles.h"
+#include "sim/RandomStream.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class CLHostSystem
+/// @brief the host side of the OpenCLUpdate particles. This makes the particle array that is uploaded to the device
+/// once and turns the emit direction each frame, the positions, life and respawn are all done in the kernel.
+//----------------------------------------------------------------------------------------------------------------------
+class CLHostSystem
+{
+public :
+
+	/// @brief ctor
+	/// @param _pos the position of the emitter
+	/// @param _numParticles the number of particles to create
+	CLHostSystem(const Vec3 &_pos, size_t _numParticles);
+	/// @brief dtor frees the particle array
+	~CLHostSystem();
+	/// @brief the emit direction for this frame's respawns, the emitter turns by the time step each call so call it
+	/// once per frame
+	Vec3 nextDirection();
+	/// @brief the particles in the layout the kernel expects, as they were made. The device copy is the live one
+	inline CLParticle *particles(){return m_particles;}
+	/// @brief the life added each frame
+	inline float step() const {return m_step;}
+	/// @brief the key for the kernel's respawn numbers, particle i respawning on frame f uses block f of stream i
+	inline uint64_t seed() const {return m_seed;}
+	inline size_t size() const {return m_numParticles;}
+	inline const Vec3 &position() const {return m_pos;}
+	/// @brief move the emitter
+	inline void updatePos(float _x, float _y, float _z){
+		m_pos.m_x+=_x;
+		m_pos.m_y+=_y;
+		m_pos.m_z+=_z;
+	}
+	/// @brief change how fast the emit direction rotates around the emitter
+	inline void incTime(float _t){m_time+=_t;}
+	inline void decTime(float _t){m_time-=_t;}
+
+private :
+	/// @brief the emit direction, a point on a circle around the emitter
+	/// @param _time the angle around the circle in degrees
+	Vec3 direction(float _time) const;
+	/// @brief the position of the emitter
+	Vec3 m_pos;
+	/// @brief the number of particles
+	size_t m_numParticles;
+	/// @brief the container for the particles
+	CLParticle *m_particles;
+	/// @brief rotation step per update in degrees
+	float m_time;
+	/// @brief the current rotation in degrees
+	float m_rotation;
+	float m_step;
+	uint64_t m_seed;
+	// the array is owned so no copies
+	CLHostSystem(const CLHostSystem &);
+	CLHostSystem &operator=(const CLHostSystem &);
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SIM_EMITTER_H__
+#define SIM_EMITTER_H__
+#include <cstddef>
+#include <vector>
+#include "sim/Layouts.h"
+#include "sim/RandomStream.h"
+#include "sim/Simd.h"
+#include "sim/Vec3.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class Emitter
+/// @brief the DDD2 / DDD3 emitter written once over a layout policy from Layouts.h, so comparing layouts is just a
+/// change of template argument rather than another copy of the update. It is built for AoSLayout, SoALayout,
+/// AoSoALayout<8> and AoSoALayout<16>.
+/// @param Layout the policy giving the Store and its accessors
+//----------------------------------------------------------------------------------------------------------------------
+template <typename Layout>
+class Emitter
+{
+public :
+	typedef typename Layout::Store Store;
+	typedef LayoutTraits<Layout> Traits;
+	/// @brief ctor
+	/// @param _pos the position of the emitter
+	/// @param _numParticles the number of particles to create
+	/// @param _seed the seed for the emitter's random stream, emitters with the same seed draw the same numbers
+	Emitter(const Vec3 &_pos, size_t _numParticles, uint64_t _seed=RandomStream::s_defaultSeed);
+	/// @brief a method to update each of the particles contained in the system, the layouts with contiguous
+	/// attributes use the SIMD kernels from simdKernels()
+	void update();
+	/// @brief set the wind vector used on the next update
+	inline void setWind(const Vec3 &_wind){m_wind=_wind;}
+	inline size_t size() const {return m_particles.size();}
+	/// @brief the position of particle _i, used to draw the particles
+	inline Vec3 position(size_t _i) const
+	{
+		return Vec3(Traits::at(m_particles,PX,_i),Traits::at(m_particles,PY,_i),Traits::at(m_particles,PZ,_i));
+	}
+	/// @brief copy every position out, what position() gives a particle at a time
+	/// @param _out where to write them
+	/// @param _stride the number of floats between each particle in _out
+	void writePositions(float *_out, size_t _stride) const;
+	/// @brief the particle storage for callers that know the layout
+	inline const Store &store() const {return m_particles;}
+	/// @brief the update works through this many particles at a time, it is a multiple of every layout block
+	static const size_t s_chunkSize=2048;
+private :
+	/// @brief give particles new directions and put them back at the emitter, the random numbers for all of them
+	/// are made in one batch
+	/// @param _first the index the entries of _which are relative to
+	/// @param _which the particles to respawn
+	/// @param _count the number of entries in _which
+	void respawn(size_t _first, const unsigned int *_which, size_t _count);
+	/// @brief the position of the emitter
+	Vec3 m_pos;
+	/// @brief the container for the particles
+	Store m_particles;
+	/// @brief a wind vector
+	Vec3 m_wind;
+	/// @brief gravity is the same for every particle
+	float m_gravity;
+	/// @brief where the respawn directions come from
+	RandomStream m_random;
+	/// @brief space for a chunk's worth of respawn random numbers
+	std::vector<float> m_randoms;
+	// the store is owned so no copies
+	Emitter(const Emitter &);
+	Emitter &operator=(const Emitter &);
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef SIM_LAYOUTS_H__
+#define SIM_LAYOUTS_H__
+#include <cstddef>
+#include "sim/Aligned.h"
+#include "sim/BlockedStore.h"
+#include "sim/ParticleStore.h"
+#include "sim/Particles.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Layouts.h
+/// @brief the layout policies for sim::Emitter. A policy names the Store holding the particles and describes it as
+/// blocks of s_blockSize particles, block() gives the first value of an attribute in a block and the next particle's
+/// value is s_stride floats on. The same attribute in the next block starts s_blockStride floats after this one.
+/// The Emitter update is written only in terms of these so one loop compiles to what each of the DDD demos used to
+/// hand code, the sizes are compile time constants and block() is inline so there is no cost over writing the loop
+/// for the layout directly.
+//----------------------------------------------------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class PackedStore
+/// @brief the DDD2 / DDD3 array of packed FlatParticle structs
+//----------------------------------------------------------------------------------------------------------------------
+class PackedStore
+{
+public :
+	explicit PackedStore(size_t _numParticles) :
+		m_numParticles(_numParticles),
+		m_particles(static_cast<FlatParticle *>(alignedAlloc(sizeof(FlatParticle)*_numParticles))){;}
+	~PackedStore(){alignedFree(m_particles);}
+	inline size_t size() const {return m_numParticles;}
+	inline FlatParticle &operator[](size_t _i){return m_particles[_i];}
+	inline const FlatParticle &operator[](size_t _i) const {return m_particles[_i];}
+private :
+	size_t m_numParticles;
+	FlatParticle *m_particles;
+	// the array is owned so no copies
+	PackedStore(const PackedStore &);
+	PackedStore &operator=(const PackedStore &);
+};
+
+/// @brief array of structures, each particle is one packed struct
+struct AoSLayout
+{
+	typedef PackedStore Store;
+	static const size_t s_blockSize=64;
+	static const size_t s_stride=sizeof(FlatParticle)/sizeof(float);
+	static const size_t s_blockStride=s_blockSize*s_stride;
+	static const char *name(){return "AoS";}
+	static inline float *block(Store &_s, Attribute _a, size_t _block)
+	{
+		return &_s[_block*s_blockSize].m_px+_a;
+	}
+	static inline const float *block(const Store &_s, Attribute _a, size_t _block)
+	{
+		return &_s[_block*s_blockSize].m_px+_a;
+	}
+};
+
+/// @brief structure of arrays, one aligned stream per attribute
+struct SoALayout
+{
+	typedef ParticleStore<float> Store;
+	static const size_t s_blockSize=1024;
+	static const size_t s_stride=1;
+	static const size_t s_blockStride=s_blockSize;
+	static const char *name(){return "SoA";}
+	static inline float *block(Store &_s, Attribute _a, size_t _block)
+	{
+		return _s.stream(_a)+_block*s_blockSize;
+	}
+	static inline const float *block(const Store &_s, Attribute _a, size_t _block)
+	{
+		return _s.stream(_a)+_block*s_blockSize;
+	}
+};
+
+/// @brief array of structures of arrays, packets of Width particles
+template <size_t Width>
+struct AoSoALayout
+{
+	typedef BlockedStore<float,Width> Store;
+	static const size_t s_blockSize=Width;
+	static const size_t s_stride=1;
+	static const size_t s_blockStride=NUM_ATTRIBUTES*Width;
+	static const char *name(){return Width==8 ? "AoSoA8" : "AoSoA16";}
+	static inline float *block(Store &_s, Attribute _a, size_t _block)
+	{
+		return _s.packet(_block).px+_a*Width;
+	}
+	static inline const float *block(const Store &_s, Attribute _a, size_t _block)
+	{
+		return _s.packet(_block).px+_a*Width;
+	}
+};
+
+/// @brief access to a single particle through any of the layouts, used for the odd particle such as a respawn
+/// rather than in the main loops
+template <typename Layout>
+struct LayoutTraits
+{
+	typedef typename Layout::Store Store;
+	static inline float &at(Store &_s, Attribute _a, size_t _i)
+	{
+		return Layout::block(_s,_a,_i/Layout::s_blockSize)[(_i%Layout::s_blockSize)*Layout::s_stride];
+	}
+	static inline float at(const Store &_s, Attribute _a, size_t _i)
+	{
+		return Layout::block(_s,_a,_i/Layout::s_blockSize)[(_i%Layout::s_blockSize)*Layout::s_stride];
+	}
+	/// @brief the number of blocks covering _numParticles, the last may be partly used
+	static inline size_t numBlocks(size_t _numParticles)
+	{
+		return (_numParticles+Layout::s_blockSize-1)/Layout::s_blockSize;
+	}
+};
+
+/// @brief the layout a demo gets unless it is built with one of SIM_LAYOUT_AOS, SIM_LAYOUT_AOSOA8 or
+/// SIM_LAYOUT_AOSOA16 defined, e.g. qmake DEFINES+=SIM_LAYOUT_AOSOA8
+#if defined(SIM_LAYOUT_AOS)
+	typedef AoSLayout DefaultLayout;
+#elif defined(SIM_LAYOUT_AOSOA8)
+	typedef AoSoALayout<8> DefaultLayout;
+#elif defined(SIM_LAYOUT_AOSOA16)
+	typedef AoSoALayout<16> DefaultLayout;
+#else
+	typedef SoALayout DefaultLayout;
+#endif
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SIM_OBJECTPARTICLE_H__
+#define SIM_OBJECTPARTICLE_H__
+#include <cstddef>
+#include "sim/Vec3.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ObjectParticle
+/// @brief the TypicalOO particle, each particle is an object that knows how to update itself and keeps a
+/// pointer to the shared wind vector
+//----------------------------------------------------------------------------------------------------------------------
+class ObjectParticle
+{
+public :
+
+	/// @brief ctor
+	/// @param _pos the start position of the particle
+	/// @param _wind the wind vector shared by all particles
+	ObjectParticle(const Vec3 &_pos, const Vec3 *_wind);
+	/// @brief a method to update the particle position
+	void update();
+	/// @brief the current position
+	inline const Vec3 &position() const {return m_pos;}
+
+private :
+	/// @brief the curent particle position
+	Vec3 m_pos;
+	/// @brief the original particle position
+	Vec3 m_origin;
+	/// @brief the direction vector of the particle
+	Vec3 m_dir;
+	/// @brief the current life value of the particle
+	float m_currentLife;
+	/// @brief gravity
+	float m_gravity;
+	/// @brief the wind vector
+	const Vec3 *m_wind;
+};
+
+/// @brief copy the positions of an array of particles out. A template so it takes arrays of classes derived from
+/// ObjectParticle too, like the TypicalOO particle which adds the drawing
+/// @param _particles the first particle
+/// @param _numParticles how many there are
+/// @param _out where to write the positions
+/// @param _stride the number of floats between each particle in _out
+template <typename Particle>
+void writePositions(const Particle *_particles, size_t _numParticles, float *_out, size_t _stride)
+{
+	for(size_t i=0; i<_numParticles; ++i)
+	{
+		const Vec3 &p=_particles[i].position();
+		_out[i*_stride]=p.m_x;
+		_out[i*_stride+1]=p.m_y;
+		_out[i*_stride+2]=p.m_z;
+	}
+}
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SIM_OBJECTSYSTEM_H__
+#define SIM_OBJECTSYSTEM_H__
+#include <cstddef>
+#include <vector>
+#include "sim/ObjectParticle.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ObjectSystem
+/// @brief a vector of ObjectParticle, the TypicalOO emitter without any of the drawing
+//----------------------------------------------------------------------------------------------------------------------
+class ObjectSystem
+{
+public :
+
+	/// @brief ctor
+	/// @param _pos the position of the emitter
+	/// @param _numParticles the number of particles to create
+	ObjectSystem(const Vec3 &_pos, size_t _numParticles);
+	/// @brief update each of the particles
+	void update();
+	/// @brief set the wind vector used on the next update
+	inline void setWind(const Vec3 &_wind){m_wind=_wind;}
+	inline size_t size() const {return m_particles.size();}
+	inline const ObjectParticle &particle(size_t _i) const {return m_particles[_i];}
+	/// @brief copy the current positions out
+	/// @param _out where to write them
+	/// @param _stride the number of floats between each particle in _out
+	inline void writePositions(float *_out, size_t _stride) const
+	{
+		sim::writePositions(m_particles.data(),m_particles.size(),_out,_stride);
+	}
+
+private :
+	/// @brief the wind vector, the particles all point at this
+	Vec3 m_wind;
+	/// @brief the container for the particles
+	std::vector <ObjectParticle> m_particles;
+	// no copies as the particles point back at m_wind
+	ObjectSystem(const ObjectSystem &);
+	ObjectSystem &operator=(const ObjectSystem &);
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef SIM_PARTICLESTORE_H__
+#define SIM_PARTICLESTORE_H__
+#include <cstddef>
+#include "sim/Aligned.h"
+
+namespace sim
+{
+/// @brief the per particle attributes, the order matches the members of FlatParticle and BlockedStore::Packet
+enum Attribute {PX,PY,PZ,DX,DY,DZ,LIFE,NUM_ATTRIBUTES};
+
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ParticleStore
+/// @brief the particles as a structure of arrays, one aligned array per attribute. An update then only pulls in
+/// the streams it actually reads and writes rather than the whole 32 byte packed particle.
+/// @param T the type of each attribute, normally float
+/// @param Alignment the alignment of every stream in bytes
+//----------------------------------------------------------------------------------------------------------------------
+template <typename T=float, size_t Alignment=s_cacheLine>
+class ParticleStore
+{
+public :
+	typedef T value_type;
+
+	/// @brief ctor
+	/// @param _numParticles the number of particles to allocate, the values are not initialised
+	explicit ParticleStore(size_t _numParticles=0) : m_numParticles(0)
+	{
+		for(int a=0; a<NUM_ATTRIBUTES; ++a)
+			m_streams[a]=0;
+		resize(_numParticles);
+	}
+	/// @brief dtor frees the streams
+	~ParticleStore(){release();}
+	/// @brief re-allocate every stream for _numParticles, any existing values are lost
+	void resize(size_t _numParticles)
+	{
+		release();
+		try
+		{
+			for(int a=0; a<NUM_ATTRIBUTES; ++a)
+				m_streams[a]=static_cast<T *>(alignedAlloc(sizeof(T)*_numParticles,Alignment));
+		}
+		catch(...)
+		{
+			release();
+			throw;
+		}
+		m_numParticles=_numParticles;
+	}
+	inline size_t size() const {return m_numParticles;}
+	/// @brief access a stream by attribute, each is Alignment aligned
+	inline T *stream(Attribute _a){return m_streams[_a];}
+	inline const T *stream(Attribute _a) const {return m_streams[_a];}
+	inline T *px(){return m_streams[PX];}
+	inline T *py(){return m_streams[PY];}
+	inline T *pz(){return m_streams[PZ];}
+	inline T *dx(){return m_streams[DX];}
+	inline T *dy(){return m_streams[DY];}
+	inline T *dz(){return m_streams[DZ];}
+	inline T *life(){return m_streams[LIFE];}
+	inline const T *px() const {return m_streams[PX];}
+	inline const T *py() const {return m_streams[PY];}
+	inline const T *pz() const {return m_streams[PZ];}
+	inline const T *dx() const {return m_streams[DX];}
+	inline const T *dy() const {return m_streams[DY];}
+	inline const T *dz() const {return m_streams[DZ];}
+	inline const T *life() const {return m_streams[LIFE];}
+
+private :
+	void release()
+	{
+		for(int a=0; a<NUM_ATTRIBUTES; ++a)
+		{
+			alignedFree(m_streams[a]);
+			m_streams[a]=0;
+		}
+		m_numParticles=0;
+	}
+	/// @brief the number of particles in each stream
+	size_t m_numParticles;
+	/// @brief one array per attribute
+	T *m_streams[NUM_ATTRIBUTES];
+	// the streams are owned so no copies
+	ParticleStore(const ParticleStore &);
+	ParticleStore &operator=(const ParticleStore &);
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef SIM_PARTICLES_H__
+#define SIM_PARTICLES_H__
+#include <stdint.h>
+#include "sim/Vec3.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Particles.h
+/// @brief the plain particle structs used by the data oriented demos
+//----------------------------------------------------------------------------------------------------------------------
+
+/// @brief DDD1 particle, a struct but still using Vec3 for the position and direction
+typedef struct Vec3Particle
+{
+  /// @brief the curent particle position
+  Vec3 m_pos;
+  /// @brief the direction vector of the particle
+  Vec3 m_dir;
+  /// @brief the current life value of the particle
+  float m_currentLife;
+  /// @brief gravity
+  float m_gravity;
+}Vec3Particle;
+
+#pragma pack(push,1)
+
+/// @brief DDD2 / DDD3 particle with everything flattened to floats
+typedef struct FlatParticle
+{
+  /// @brief the curent particle position
+  float m_px;
+  float m_py;
+  float m_pz;
+  /// @brief the direction vector of the particle
+  float m_dx;
+  float m_dy;
+  float m_dz;
+  /// @brief the current life value of the particle
+  float m_currentLife;
+  /// @brief gravity
+  float m_gravity;
+}FlatParticle;
+
+/// @brief the OpenCL particle, gravity is passed to the kernel so it isn't stored
+typedef struct CLParticle
+{
+  float m_px;
+  float m_py;
+  float m_pz;
+  float m_dx;
+  float m_dy;
+  float m_dz;
+  float m_currentLife;
+}CLParticle;
+
+/// @brief the position only particle that is sent to the GPU
+typedef struct GLParticle
+{
+  float px;
+  float py;
+  float pz;
+}GLParticle;
+
+/// @brief what the analytic render mode keeps on the GPU for each particle, its direction and the frame it was
+/// (re)spawned on. The vertex shader works the position out from these and the current frame
+typedef struct GLSpawn
+{
+  float dx;
+  float dy;
+  float dz;
+  float birth;
+}GLSpawn;
+
+/// @brief the whole particle as the GPU updates keep it (DDD3UseTheGPU transform feedback and compute), 32 bytes
+/// and all scalars so it is the same in a vertex buffer and a std430 shader storage block
+typedef struct GPUParticle
+{
+  float m_px;
+  float m_py;
+  float m_pz;
+  float m_dx;
+  float m_dy;
+  float m_dz;
+  float m_currentLife;
+  /// @brief picks the random numbers for the next respawn
+  uint32_t m_respawns;
+}GPUParticle;
+
+#pragma pack(pop)
+
+} // end namespace sim
+
+#endif
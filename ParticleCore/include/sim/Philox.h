@@ -0,0 +1,47 @@
+#ifndef SIM_PHILOX_H__
+#define SIM_PHILOX_H__
+#include <stdint.h>
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Philox.h
+/// @brief the Philox4x32-10 counter based generator (Salmon et al. "Parallel Random Numbers: As Easy as 1, 2, 3").
+/// The output is a pure function of a 64 bit key and a 128 bit counter, so any number of independent streams can
+/// be made by giving each its own counter range and there is no shared state to lock.
+//----------------------------------------------------------------------------------------------------------------------
+namespace philox
+{
+	static const uint32_t s_m0=0xD2511F53;
+	static const uint32_t s_m1=0xCD9E8D57;
+	static const uint32_t s_w0=0x9E3779B9;
+	static const uint32_t s_w1=0xBB67AE85;
+	static const int s_rounds=10;
+	/// @brief 2^-24, the top 24 bits of an output make a float in [0,1)
+	static const float s_toFloat=1.0f/16777216.0f;
+
+	/// @brief encrypt the counter _c with the key _k0,_k1, the result replaces _c
+	inline void block(uint32_t _c[4], uint32_t _k0, uint32_t _k1)
+	{
+		for(int r=0; r<s_rounds; ++r)
+		{
+			uint64_t p0=static_cast<uint64_t>(s_m0)*_c[0];
+			uint64_t p1=static_cast<uint64_t>(s_m1)*_c[2];
+			uint32_t c0=static_cast<uint32_t>(p1>>32)^_c[1]^_k0;
+			uint32_t c2=static_cast<uint32_t>(p0>>32)^_c[3]^_k1;
+			_c[1]=static_cast<uint32_t>(p1);
+			_c[3]=static_cast<uint32_t>(p0);
+			_c[0]=c0;
+			_c[2]=c2;
+			_k0+=s_w0;
+			_k1+=s_w1;
+		}
+	}
+
+	/// @brief an output word as a float in [0,1), exactly representable so every SIMD level agrees
+	inline float toFloat(uint32_t _x){return static_cast<float>(_x>>8)*s_toFloat;}
+} // end namespace philox
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SIM_RANDOM_H__
+#define SIM_RANDOM_H__
+#include <random>
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class Random
+/// @brief a stand in for ngl::Random so the simulation can run without NGL. It keeps the same singleton interface
+/// as the NGL version so the update loops make exactly the same calls per particle as they always have.
+//----------------------------------------------------------------------------------------------------------------------
+class Random
+{
+  public :
+    /// @brief get the single instance, as with ngl::Random this is shared by everything
+    static Random *instance();
+    /// @brief a random number in the range -_mult to +_mult
+    inline float randomNumber(float _mult=1.0f){return m_signed(m_generator)*_mult;}
+    /// @brief a random number in the range 0 to _mult
+    inline float randomPositiveNumber(float _mult=1.0f){return m_positive(m_generator)*_mult;}
+    /// @brief re-seed, used by the benchmark so each run sees the same sequence
+    inline void setSeed(unsigned int _seed){m_generator.seed(_seed);}
+
+  private :
+    Random();
+    /// @brief the generator, mt19937 as used by NGL
+    std::mt19937 m_generator;
+    std::uniform_real_distribution<float> m_signed;
+    std::uniform_real_distribution<float> m_positive;
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SIM_RANDOMSTREAM_H__
+#define SIM_RANDOMSTREAM_H__
+#include <cstddef>
+#include <stdint.h>
+#include "sim/Philox.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class RandomStream
+/// @brief one independent stream of Philox4x32 random numbers. Streams with the same seed and a different stream
+/// id never overlap, so each thread owns one and nothing is shared. It has the randomNumber /
+/// randomPositiveNumber calls of sim::Random for single draws and uniform() to fill a whole batch at once with
+/// the SIMD kernels from simdKernels().
+//----------------------------------------------------------------------------------------------------------------------
+class RandomStream
+{
+public :
+	/// @brief the seed used when none is given, the same one sim::Random starts with
+	static const uint64_t s_defaultSeed=12345;
+	/// @brief ctor
+	/// @param _seed the key shared by all the streams of a run
+	/// @param _stream which stream, the high 64 bits of the counter
+	explicit RandomStream(uint64_t _seed=s_defaultSeed, uint64_t _stream=0);
+	/// @brief start the stream again from the beginning with a new seed and stream id
+	void reset(uint64_t _seed, uint64_t _stream);
+	/// @brief the next 32 random bits
+	inline uint32_t next()
+	{
+		if(m_used==4)
+			refill();
+		return m_buffer[m_used++];
+	}
+	/// @brief a random number in the range [0,1)
+	inline float uniform(){return philox::toFloat(next());}
+	/// @brief a random number in the range -_mult to +_mult
+	inline float randomNumber(float _mult=1.0f){return (uniform()*2.0f-1.0f)*_mult;}
+	/// @brief a random number in the range 0 to _mult
+	inline float randomPositiveNumber(float _mult=1.0f){return uniform()*_mult;}
+	/// @brief fill _out with _n numbers in [0,1) using the SIMD kernel, this always starts on a fresh counter so
+	/// any single draws left over from next() are skipped
+	void uniform(float *_out, size_t _n);
+	/// @brief block _counter of stream _stream as floats in [0,1) without making a stream, the same 4 numbers
+	/// RandomStream(_seed,_stream) gives for that block. Used where the numbers have to come from who is asking
+	/// (a particle id) rather than from which thread happens to run it
+	static void uniformAt(uint64_t _seed, uint64_t _stream, uint64_t _counter, float _out[4]);
+
+private :
+	/// @brief generate the next block of 4 into m_buffer
+	void refill();
+	/// @brief the key
+	uint32_t m_key[2];
+	/// @brief the stream id, the high half of the counter
+	uint32_t m_stream[2];
+	/// @brief the block number, the low half of the counter
+	uint64_t m_counter;
+	/// @brief the current block and how much of it has been used
+	uint32_t m_buffer[4];
+	unsigned int m_used;
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef SIM_SIMD_H__
+#define SIM_SIMD_H__
+#include <cstddef>
+#include <stdint.h>
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @file Simd.h
+/// @brief hand vectorised versions of the two hot loops of the emitter update, the projectile step and the test
+/// for particles that need respawning. One set is picked when the program starts from what the CPU supports, so
+/// a single build runs on every node and still uses AVX-512 where it is there.
+///
+/// The kernels work on contiguous streams of floats (SoA or the packets of an AoSoA store). The data is walked as
+/// runs of _runLength floats with the start of each run _runStride floats after the last, for a SoA store that
+/// is just one long run. Every level does the same operations in the same order (no FMA) so the results are bit
+/// identical whichever one is picked.
+//----------------------------------------------------------------------------------------------------------------------
+
+/// @brief the instruction sets we have kernels for, in order of preference
+enum SimdLevel {SIMD_SCALAR, SIMD_SSE4, SIMD_AVX2, SIMD_AVX512};
+
+/// @brief the values that are the same for every particle, read once per update rather than per particle
+struct ProjectileParams
+{
+	float m_wx;
+	float m_wy;
+	float m_wz;
+	float m_ox;
+	float m_oy;
+	float m_oz;
+	float m_gravity;
+	/// @brief the life added each update
+	float m_step;
+};
+
+/// @brief the first value of each stream the kernels read or write
+struct Streams
+{
+	float *m_px;
+	float *m_py;
+	float *m_pz;
+	const float *m_dx;
+	const float *m_dy;
+	const float *m_dz;
+	float *m_life;
+};
+
+/// @brief advance life and compute the new position of _count particles
+typedef void (*ProjectileKernel)(const ProjectileParams &_params, const Streams &_streams, size_t _count,
+																 size_t _runLength, size_t _runStride);
+/// @brief write the index (from 0 to _count) of every particle with py <= _floor into _dead, in order
+/// @returns the number of indices written
+typedef size_t (*FindDeadKernel)(const float *_py, size_t _count, size_t _runLength, size_t _runStride,
+																 float _floor, unsigned int *_dead);
+
+/// @brief fill _out with _numBlocks*4 Philox4x32 numbers in [0,1), block b of 4 uses the counter
+/// (_counter+b, _stream) so the result is the same as _numBlocks calls of the scalar generator
+typedef void (*RandomKernel)(const uint32_t _key[2], const uint32_t _stream[2], uint64_t _counter, float *_out,
+														 size_t _numBlocks);
+
+/// @brief one set of kernels for an instruction set
+struct SimdKernels
+{
+	SimdLevel m_level;
+	const char *m_name;
+	ProjectileKernel projectile;
+	FindDeadKernel findDead;
+	RandomKernel random;
+};
+
+/// @brief the best level this CPU (and OS) supports, always SIMD_SCALAR on a non x86 or non GCC / Clang build
+SimdLevel detectSimd();
+/// @brief the kernels used by the emitters, chosen on first use. This is detectSimd() unless the SIM_SIMD
+/// environment variable is set to scalar, sse4, avx2 or avx512 to force a lower level for testing
+const SimdKernels &simdKernels();
+/// @brief the kernels for a given level, if the CPU can't run it the best supported level below it is returned
+const SimdKernels &simdKernels(SimdLevel _level);
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef SIM_STREAMINGSYSTEM_H__
+#define SIM_STREAMINGSYSTEM_H__
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+#include "sim/Particles.h"
+#include "sim/RandomStream.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class StreamingSystem
+/// @brief the DDD3UseTheGPU particles, the packed particle array plus the position is written straight out to a
+/// vertex buffer (or any float array) as part of the update
+///
+/// By default each pool thread draws respawn directions from its own stream, which is fast but means which
+/// numbers a particle gets depends on how the loop was scheduled. In deterministic mode particle i's directions
+/// come from block (respawn count) of stream i instead, so the frames are bit identical for any number of threads
+/// and a run can be replayed from just the seed.
+//----------------------------------------------------------------------------------------------------------------------
+class StreamingSystem
+{
+public :
+
+	/// @brief ctor
+	/// @param _pos the position of the emitter
+	/// @param _numParticles the number of particles to create
+	/// @param _step the amount of life added each update
+	/// @param _parallel run the update on the shared ThreadPool
+	/// @param _deterministic derive every particle's random numbers from (seed, particle id, respawn count)
+	/// @param _seed the seed for the run
+	/// The particles are created in parallel on the pool when _parallel is set, each thread fills its own chunks
+	/// so the pages are placed near it
+	StreamingSystem(const Vec3 &_pos, size_t _numParticles, float _step, bool _parallel,
+									bool _deterministic=false, uint64_t _seed=RandomStream::s_defaultSeed);
+	/// @brief dtor frees the particle array
+	~StreamingSystem();
+	/// @brief update each of the particles and write the new position
+	/// @param _out where to write the positions, this is normally the mapped VBO
+	/// @param _stride the number of floats between each particle in _out
+	void update(float *_out, size_t _stride);
+	/// @brief the same update but the positions are only written to _out, packed 3 floats per particle, and not
+	/// kept in the particles. The stores bypass the cache (non-temporal) as _out is normally a write combined
+	/// mapped vertex buffer that the CPU never reads back. Use this or update(), not both
+	void stream(float *_out);
+	/// @brief write the current positions without updating, used to fill the VBO the first time. These are worked
+	/// out from the life and the current wind so are right after either update. This is split across the pool
+	/// like update() when the system is parallel
+	void writePositions(float *_out, size_t _stride) const;
+	/// @brief the same update again but no positions are written at all, for when the vertex shader works them out
+	/// (see GLSpawn). Only the particles that respawn write a new record to _spawns, so the GPU copy of the
+	/// array only gets the respawns each frame
+	/// @param _spawns the copy of the records to bring up to date
+	/// @param _frames how many updates ago _spawns was last brought up to date, when the GPU has several copies
+	/// in a ring each one has missed the respawns written to the others. Particles that respawned in any of those
+	/// updates are written again
+	void advance(GLSpawn *_spawns, unsigned int _frames=1);
+	/// @brief write every particle's spawn record, used to fill the GPU copy the first time. The birth frame is
+	/// worked back from the life so the shader carries on from wherever the last update left the particle
+	void writeSpawns(GLSpawn *_spawns) const;
+	/// @brief set the wind vector used on the next update
+	inline void setWind(const Vec3 &_wind){m_wind=_wind;}
+	inline size_t size() const {return m_numParticles;}
+	/// @brief the particle, the position in it isn't kept up to date by stream()
+	inline const FlatParticle &particle(size_t _i) const {return m_particles[_i];}
+	inline bool deterministic() const {return m_respawns!=0;}
+	/// @brief how many times particle _i has been respawned, only kept in deterministic mode
+	inline uint32_t respawnCount(size_t _i) const {return m_respawns ? m_respawns[_i] : 0;}
+	/// @brief how many updates there have been, the clock the GLSpawn birth frames are on
+	inline uint32_t frame() const {return m_frame;}
+	inline float step() const {return m_step;}
+	inline const Vec3 &position() const {return m_pos;}
+
+private :
+	/// @brief the position of the emitter
+	Vec3 m_pos;
+	/// @brief the number of particles
+	size_t m_numParticles;
+	/// @brief the container for the particles
+	FlatParticle *m_particles;
+	/// @brief a wind vector
+	Vec3 m_wind;
+	/// @brief life added per update
+	float m_step;
+	/// @brief updates so far, bumped by each of update(), stream() and advance()
+	uint32_t m_frame;
+	/// @brief split the update across ThreadPool::instance()
+	bool m_parallel;
+	/// @brief a random stream for each pool thread, padded so two threads never share a cache line
+	struct ThreadStream
+	{
+		RandomStream m_random;
+		char m_pad[64];
+	};
+	std::vector<ThreadStream> m_streams;
+	/// @brief the seed, only used directly in deterministic mode
+	uint64_t m_seed;
+	/// @brief the respawn count of each particle in deterministic mode, 0 (not allocated) otherwise
+	uint32_t *m_respawns;
+	/// @brief set the direction of particle _i from its own stream, the block used is its respawn count
+	void spawnDeterministic(size_t _i);
+	/// @brief create particles _begin to _end (at most s_spawnChunk of them), run on pool thread _thread
+	void spawnRange(size_t _begin, size_t _end, unsigned int _thread);
+	/// @brief update particles _begin to _end, run on pool thread _thread
+	void updateRange(float *_out, size_t _stride, size_t _begin, size_t _end, unsigned int _thread);
+	/// @brief reset the life of particle _i and give it a new direction
+	void respawn(size_t _i, unsigned int _thread);
+	/// @brief stream() for particles _begin to _end
+	void streamRange(float *_out, size_t _begin, size_t _end, unsigned int _thread);
+	/// @brief update particle _i and write its position to o_pos
+	inline void streamParticle(size_t _i, float *o_pos, unsigned int _thread);
+	/// @brief advance() for particles _begin to _end
+	void advanceRange(GLSpawn *_spawns, unsigned int _frames, size_t _begin, size_t _end, unsigned int _thread);
+	/// @brief write the positions of particles _begin to _end to _out
+	void writeRange(float *_out, size_t _stride, size_t _begin, size_t _end) const;
+	// the array is owned so no copies
+	StreamingSystem(const StreamingSystem &);
+	StreamingSystem &operator=(const StreamingSystem &);
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef SIM_THREADPOOL_H__
+#define SIM_THREADPOOL_H__
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class ThreadPool
+/// @brief a small work stealing pool used for the parallel updates in place of #pragma omp parallel for. A range is
+/// cut into chunks and each thread starts with an even, contiguous share of them. A thread takes its own chunks from
+/// the front and when it runs out it steals the back half of whatever another thread has left, so a thread that was
+/// held up by other work in the process (another emitter, the UI) just does less rather than holding up the frame.
+/// Idle workers sleep on a condition variable rather than spinning like an OpenMP team.
+///
+/// There is one pool per process (instance()) shared by every emitter, jobs from different threads run one at a
+/// time and a parallelFor called from inside a job runs serially on the calling thread.
+//----------------------------------------------------------------------------------------------------------------------
+class ThreadPool
+{
+public :
+	/// @brief the work for a chunk, _begin to _end of the range run on pool thread _thread (0 is the caller)
+	typedef std::function<void(size_t _begin, size_t _end, unsigned int _thread)> RangeFunction;
+	/// @brief roughly how much data a chunk should touch, about an L1 cache worth
+	static const size_t s_chunkBytes=32*1024;
+
+	/// @brief the pool shared by the whole process, SIM_THREADS sets the number of threads (including the calling
+	/// one) otherwise it is std::thread::hardware_concurrency()
+	static ThreadPool &instance();
+	/// @brief ctor starts _numThreads-1 workers, the thread calling parallelFor is the last one
+	explicit ThreadPool(unsigned int _numThreads);
+	/// @brief dtor stops and joins the workers
+	~ThreadPool();
+	/// @brief the number of threads a job can run on including the caller, thread indices are below this
+	inline unsigned int numThreads() const {return m_numThreads;}
+	/// @brief the number of items per chunk so one chunk touches about s_chunkBytes, a multiple of 16 so chunk
+	/// boundaries in float arrays fall on cache lines
+	static size_t chunkSize(size_t _bytesPerItem);
+	/// @brief run _func over _begin to _end in chunks of _chunkSize and return when it has all been done. _func is
+	/// never given more than _chunkSize items at once, even when it all runs on the calling thread
+	void parallelFor(size_t _begin, size_t _end, size_t _chunkSize, const RangeFunction &_func);
+
+private :
+	/// @brief the chunks a thread has left, [m_first,m_last) in chunk numbers. Padded so two threads' queues are
+	/// never on the same cache line
+	struct Queue
+	{
+		std::mutex m_lock;
+		size_t m_first;
+		size_t m_last;
+		char m_pad[64];
+	};
+	/// @brief run a job a chunk at a time on this thread
+	static void runSerial(size_t _begin, size_t _end, size_t _chunkSize, const RangeFunction &_func,
+												unsigned int _thread);
+	/// @brief the loop each worker runs until the pool is destroyed
+	void worker(unsigned int _thread);
+	/// @brief run chunks from our own queue then steal until there are none left anywhere
+	void runChunks(unsigned int _thread);
+	/// @brief take the first chunk of queue _thread
+	bool popChunk(unsigned int _thread, size_t &_chunk);
+	/// @brief move the back half of another thread's chunks into queue _thread
+	bool steal(unsigned int _thread);
+	/// @brief run chunk _chunk of the current job
+	void runChunk(size_t _chunk, unsigned int _thread);
+
+	unsigned int m_numThreads;
+	std::vector<std::thread> m_workers;
+	/// @brief one per thread, allocated as an array so they stay put
+	Queue *m_queues;
+	/// @brief the current job
+	const RangeFunction *m_func;
+	size_t m_begin;
+	size_t m_end;
+	size_t m_chunkSize;
+	/// @brief guards the job, m_generation, m_busy and m_stop
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	/// @brief bumped for each job so a worker knows there is new work
+	unsigned long m_generation;
+	/// @brief workers still looking at the current job
+	unsigned int m_busy;
+	bool m_stop;
+	/// @brief only one job at a time
+	std::mutex m_submit;
+	// owns threads so no copies
+	ThreadPool(const ThreadPool &);
+	ThreadPool &operator=(const ThreadPool &);
+};
+
+} // end namespace sim
+
+#endif
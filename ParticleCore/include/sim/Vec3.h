@@ -0,0 +1,21 @@
+#ifndef SIM_VEC3_H__
+#define SIM_VEC3_H__
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class Vec3
+/// @brief a plain 3 float vector so the simulation doesn't depend on ngl::Vec3, it has the same layout
+/// (m_x,m_y,m_z) so the demos can copy straight across
+//----------------------------------------------------------------------------------------------------------------------
+struct Vec3
+{
+  Vec3(float _x=0.0f, float _y=0.0f, float _z=0.0f) : m_x(_x), m_y(_y), m_z(_z){;}
+  float m_x;
+  float m_y;
+  float m_z;
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef SIM_VEC3SYSTEM_H__
+#define SIM_VEC3SYSTEM_H__
+#include <cstddef>
+#include <vector>
+#include "sim/Particles.h"
+
+namespace sim
+{
+//----------------------------------------------------------------------------------------------------------------------
+/// @class Vec3System
+/// @brief the DDD1 particles, a vector of structs and the update loop moved out of the particle
+//----------------------------------------------------------------------------------------------------------------------
+class Vec3System
+{
+public :
+
+	/// @brief ctor
+	/// @param _pos the position of the emitter
+	/// @param _numParticles the number of particles to create
+	Vec3System(const Vec3 &_pos, size_t _numParticles);
+	/// @brief a method to update each of the particles contained in the system
+	void update();
+	/// @brief set the wind vector used on the next update
+	inline void setWind(const Vec3 &_wind){m_wind=_wind;}
+	inline size_t size() const {return m_numParticles;}
+	inline const Vec3Particle &particle(size_t _i) const {return m_particles[_i];}
+	/// @brief copy the current positions out, e.g. to the demo's instance buffer
+	/// @param _out where to write them
+	/// @param _stride the number of floats between each particle in _out
+	void writePositions(float *_out, size_t _stride) const;
+
+private :
+	/// @brief the position of the emitter
+	Vec3 m_pos;
+	/// @brief the number of particles
+	size_t m_numParticles;
+	/// @brief the container for the particles
+	std::vector <Vec3Particle> m_particles;
+	/// @brief a wind vector
+	Vec3 m_wind;
+};
+
+} // end namespace sim
+
+#endif
@@ -0,0 +1,53 @@
+#include "sim/CLHostSystem.h"
+#include <cmath>
+
+namespace sim
+{
+
+CLHostSystem::CLHostSystem(const Vec3 &_pos, size_t _numParticles) :
+	m_time(0.0f), m_rotation(0.0f), m_step(0.02f), m_seed(RandomStream::s_defaultSeed)
+{
+	CLParticle p;
+	// the kernel only uses streams below 2^32 (one per particle) so this can't overlap any of its numbers
+	RandomStream random(m_seed,static_cast<uint64_t>(1)<<32);
+	RandomStream *rand=&random;
+	m_pos=_pos;
+	m_particles = new CLParticle[_numParticles];
+	Vec3 end=direction(m_time);
+
+	for (size_t i=0; i< _numParticles; ++i)
+	{
+		p.m_px=m_pos.m_x;
+		p.m_py=m_pos.m_y;
+		p.m_pz=m_pos.m_z;
+		p.m_dx=end.m_x+rand->randomNumber(2)+0.5f;
+		p.m_dy=end.m_y+rand->randomPositiveNumber(10)+0.5f;
+		p.m_dz=end.m_z+rand->randomNumber(2)+0.5f;
+
+		p.m_currentLife=0.0f;
+		m_particles[i]=p;
+	}
+	m_numParticles=_numParticles;
+}
+
+CLHostSystem::~CLHostSystem()
+{
+	delete [] m_particles;
+}
+
+Vec3 CLHostSystem::direction(float _time) const
+{
+	const float toRadians=3.14159265358979f/180.0f;
+	float pointOnCircleX= cosf(_time*toRadians)*4.0f;
+	float pointOnCircleZ= sinf(_time*toRadians)*4.0f;
+	return Vec3(pointOnCircleX-m_pos.m_x,2.0f-m_pos.m_y,pointOnCircleZ-m_pos.m_z);
+}
+
+Vec3 CLHostSystem::nextDirection()
+{
+	Vec3 end=direction(m_rotation);
+	m_rotation+=m_time;
+	return end;
+}
+
+} // end namespace sim
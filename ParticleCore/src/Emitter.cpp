@@ -0,0 +1,125 @@
+#include "sim/Emitter.h"
+
+namespace sim
+{
+
+template <typename Layout>
+Emitter<Layout>::Emitter(const Vec3 &_pos, size_t _numParticles, uint64_t _seed) :
+	m_pos(_pos), m_particles(_numParticles), m_wind(1,1,1), m_gravity(-9.0f), m_random(_seed),
+	m_randoms(3*s_chunkSize)
+{
+	// spawning everything is a respawn of every particle a chunk at a time
+	unsigned int all[s_chunkSize];
+	for(size_t i=0; i<s_chunkSize; ++i)
+		all[i]=static_cast<unsigned int>(i);
+	for(size_t first=0; first<_numParticles; first+=s_chunkSize)
+	{
+		const size_t count = _numParticles-first < s_chunkSize ? _numParticles-first : s_chunkSize;
+		respawn(first,all,count);
+	}
+}
+
+template <typename Layout>
+void Emitter<Layout>::respawn(size_t _first, const unsigned int *_which, size_t _count)
+{
+	// three numbers a particle, dx and dz in [-5,5] and dy in [0,10] as ngl::Random gave
+	m_random.uniform(&m_randoms[0],3*_count);
+	for(size_t w=0; w<_count; ++w)
+	{
+		const size_t i=_first+_which[w];
+		const float *r=&m_randoms[3*w];
+		Traits::at(m_particles,PX,i)=m_pos.m_x;
+		Traits::at(m_particles,PY,i)=m_pos.m_y;
+		Traits::at(m_particles,PZ,i)=m_pos.m_z;
+		Traits::at(m_particles,DX,i)=(r[0]*2.0f-1.0f)*5.0f+0.5f;
+		Traits::at(m_particles,DY,i)=r[1]*10.0f+0.5f;
+		Traits::at(m_particles,DZ,i)=(r[2]*2.0f-1.0f)*5.0f+0.5f;
+		Traits::at(m_particles,LIFE,i)=0.0f;
+	}
+}
+
+template <typename Layout>
+void Emitter<Layout>::update()
+{
+	const size_t numParticles=m_particles.size();
+	static_assert(s_chunkSize%Layout::s_blockSize==0,"a chunk must be whole layout blocks");
+	// everything that is the same for each particle is read once here rather than in the loop
+	ProjectileParams params;
+	params.m_wx=m_wind.m_x;
+	params.m_wy=m_wind.m_y;
+	params.m_wz=m_wind.m_z;
+	params.m_ox=m_pos.m_x;
+	params.m_oy=m_pos.m_y;
+	params.m_oz=m_pos.m_z;
+	params.m_gravity=m_gravity;
+	params.m_step=0.05f;
+	const float floor=m_pos.m_y-0.01f;
+	const SimdKernels &kernels=simdKernels();
+	unsigned int dead[s_chunkSize];
+
+	for(size_t first=0; first<numParticles; first+=s_chunkSize)
+	{
+		const size_t count = numParticles-first < s_chunkSize ? numParticles-first : s_chunkSize;
+		const size_t block=first/Layout::s_blockSize;
+		Streams s;
+		s.m_px=Layout::block(m_particles,PX,block);
+		s.m_py=Layout::block(m_particles,PY,block);
+		s.m_pz=Layout::block(m_particles,PZ,block);
+		s.m_dx=Layout::block(m_particles,DX,block);
+		s.m_dy=Layout::block(m_particles,DY,block);
+		s.m_dz=Layout::block(m_particles,DZ,block);
+		s.m_life=Layout::block(m_particles,LIFE,block);
+		size_t numDead=0;
+		if(Layout::s_stride==1)
+		{
+			kernels.projectile(params,s,count,Layout::s_blockSize,Layout::s_blockStride);
+			numDead=kernels.findDead(s.m_py,count,Layout::s_blockSize,Layout::s_blockStride,floor,dead);
+		}
+		else
+		{
+			// interleaved attributes (AoS) can't use the kernels, the blocks are contiguous so walk the chunk as one
+			const size_t stride=Layout::s_stride;
+			for(size_t i=0; i<count; ++i)
+			{
+				const size_t j=i*stride;
+				float t=s.m_life[j]+params.m_step;
+				s.m_life[j]=t;
+				// use projectile motion equation to calculate the new position
+				// x(t)=Ix+Vxt
+				// y(t)=Iy+Vxt-1/2gt^2
+				// z(t)=Iz+Vzt
+				s.m_px[j]=params.m_ox+params.m_wx*s.m_dx[j]*t;
+				s.m_py[j]=params.m_oy+params.m_wy*s.m_dy[j]*t+params.m_gravity*(t*t);
+				s.m_pz[j]=params.m_oz+params.m_wz*s.m_dz[j]*t;
+			}
+			for(size_t i=0; i<count; ++i)
+			{
+				if(s.m_py[i*stride] <= floor)
+					dead[numDead++]=static_cast<unsigned int>(i);
+			}
+		}
+		// if we go below the origin re-set, this is rare so it is done from the list while the chunk is in cache
+		if(numDead)
+			respawn(first,dead,numDead);
+	}
+}
+
+template <typename Layout>
+void Emitter<Layout>::writePositions(float *_out, size_t _stride) const
+{
+	const size_t numParticles=m_particles.size();
+	for(size_t i=0; i<numParticles; ++i)
+	{
+		_out[i*_stride]=Traits::at(m_particles,PX,i);
+		_out[i*_stride+1]=Traits::at(m_particles,PY,i);
+		_out[i*_stride+2]=Traits::at(m_particles,PZ,i);
+	}
+}
+
+// the layouts we build for, see Layouts.h
+template class Emitter<AoSLayout>;
+template class Emitter<SoALayout>;
+template class Emitter<AoSoALayout<8> >;
+template class Emitter<AoSoALayout<16> >;
+
+} // end namespace sim
@@ -0,0 +1,45 @@
+#include "sim/ObjectParticle.h"
+#include "sim/Random.h"
+
+namespace sim
+{
+
+/// @brief ctor
+/// @param _pos the start position of the particle
+ObjectParticle::ObjectParticle(const Vec3 &_pos, const Vec3 *_wind)
+{
+	m_pos=_pos;
+	m_origin=_pos;
+	m_wind=_wind;
+	Random *rand=Random::instance();
+	m_dir.m_x=rand->randomNumber(5)+0.5f;
+	m_dir.m_y=rand->randomPositiveNumber(10)+0.5f;
+	m_dir.m_z=rand->randomNumber(5)+0.5f;
+	m_currentLife=0.0f;
+	m_gravity=-9.0f;//4.65;
+}
+/// @brief a method to update the particle position
+void ObjectParticle::update()
+{
+	m_currentLife+=0.05f;
+	// use projectile motion equation to calculate the new position
+	// x(t)=Ix+Vxt
+	// y(t)=Iy+Vxt-1/2gt^2
+	// z(t)=Iz+Vzt
+	m_pos.m_x=m_origin.m_x+(m_wind->m_x*m_dir.m_x*m_currentLife);
+	m_pos.m_y= m_origin.m_y+(m_wind->m_y*m_dir.m_y*m_currentLife)+m_gravity*(m_currentLife*m_currentLife);
+	m_pos.m_z=m_origin.m_z+(m_wind->m_z*m_dir.m_z*m_currentLife);
+
+	// if we go below the origin re-set
+	if(m_pos.m_y <= m_origin.m_y-0.01f)
+	{
+		m_pos=m_origin;
+		m_currentLife=0.0f;
+		Random *rand=Random::instance();
+		m_dir.m_x=rand->randomNumber(5)+0.5f;
+		m_dir.m_y=rand->randomPositiveNumber(10)+0.5f;
+		m_dir.m_z=rand->randomNumber(5)+0.5f;
+	}
+}
+
+} // end namespace sim
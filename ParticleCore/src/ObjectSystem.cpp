@@ -0,0 +1,23 @@
+#include "sim/ObjectSystem.h"
+
+namespace sim
+{
+
+ObjectSystem::ObjectSystem(const Vec3 &_pos, size_t _numParticles) : m_wind(1,1,1)
+{
+	for (size_t i=0; i< _numParticles; ++i)
+	{
+		m_particles.push_back(ObjectParticle(_pos,&m_wind));
+	}
+}
+
+void ObjectSystem::update()
+{
+	size_t size=m_particles.size();
+	for(size_t i=0; i<size; ++i)
+	{
+		m_particles[i].update();
+	}
+}
+
+} // end namespace sim
@@ -0,0 +1,17 @@
+#include "sim/Random.h"
+
+namespace sim
+{
+
+Random::Random() : m_signed(-1.0f,1.0f), m_positive(0.0f,1.0f)
+{
+  m_generator.seed(12345);
+}
+
+Random *Random::instance()
+{
+  static Random s_instance;
+  return &s_instance;
+}
+
+} // end namespace sim
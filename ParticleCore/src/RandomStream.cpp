@@ -0,0 +1,56 @@
+#include "sim/RandomStream.h"
+#include "sim/Simd.h"
+
+namespace sim
+{
+
+RandomStream::RandomStream(uint64_t _seed, uint64_t _stream)
+{
+	reset(_seed,_stream);
+}
+
+void RandomStream::reset(uint64_t _seed, uint64_t _stream)
+{
+	m_key[0]=static_cast<uint32_t>(_seed);
+	m_key[1]=static_cast<uint32_t>(_seed>>32);
+	m_stream[0]=static_cast<uint32_t>(_stream);
+	m_stream[1]=static_cast<uint32_t>(_stream>>32);
+	m_counter=0;
+	m_used=4;
+}
+
+void RandomStream::refill()
+{
+	m_buffer[0]=static_cast<uint32_t>(m_counter);
+	m_buffer[1]=static_cast<uint32_t>(m_counter>>32);
+	m_buffer[2]=m_stream[0];
+	m_buffer[3]=m_stream[1];
+	philox::block(m_buffer,m_key[0],m_key[1]);
+	++m_counter;
+	m_used=0;
+}
+
+void RandomStream::uniform(float *_out, size_t _n)
+{
+	size_t numBlocks=_n/4;
+	simdKernels().random(m_key,m_stream,m_counter,_out,numBlocks);
+	m_counter+=numBlocks;
+	m_used=4;
+	// the last few that don't make up a whole block
+	for(size_t i=numBlocks*4; i<_n; ++i)
+		_out[i]=uniform();
+}
+
+void RandomStream::uniformAt(uint64_t _seed, uint64_t _stream, uint64_t _counter, float _out[4])
+{
+	uint32_t c[4];
+	c[0]=static_cast<uint32_t>(_counter);
+	c[1]=static_cast<uint32_t>(_counter>>32);
+	c[2]=static_cast<uint32_t>(_stream);
+	c[3]=static_cast<uint32_t>(_stream>>32);
+	philox::block(c,static_cast<uint32_t>(_seed),static_cast<uint32_t>(_seed>>32));
+	for(int i=0; i<4; ++i)
+		_out[i]=philox::toFloat(c[i]);
+}
+
+} // end namespace sim
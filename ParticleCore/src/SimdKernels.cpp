@@ -0,0 +1,466 @@
+#include "sim/Simd.h"
+#include "sim/Philox.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+// the vector kernels need the GCC / Clang target attribute so the rest of the library can be built for the base
+// instruction set, anywhere else only the scalar kernels are built
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define SIM_X86_DISPATCH
+	#include <immintrin.h>
+	// GCC 12 warns about the _mm512_undefined_* values inside its own AVX-512 headers when the file isn't built
+	// with -mavx512f, they are meant to be undefined
+	#if defined(__GNUC__) && !defined(__clang__)
+		#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+	#endif
+#endif
+
+namespace sim
+{
+
+//----------------------------------------------------------------------------------------------------------------------
+// scalar, also used for the tails of the SSE and AVX2 kernels
+//----------------------------------------------------------------------------------------------------------------------
+static inline void projectileOne(const ProjectileParams &_p, const Streams &_s, size_t _j)
+{
+	float t=_s.m_life[_j]+_p.m_step;
+	_s.m_life[_j]=t;
+	// use projectile motion equation to calculate the new position
+	// x(t)=Ix+Vxt
+	// y(t)=Iy+Vxt-1/2gt^2
+	// z(t)=Iz+Vzt
+	_s.m_px[_j]=_p.m_ox+_p.m_wx*_s.m_dx[_j]*t;
+	_s.m_py[_j]=_p.m_oy+_p.m_wy*_s.m_dy[_j]*t+_p.m_gravity*(t*t);
+	_s.m_pz[_j]=_p.m_oz+_p.m_wz*_s.m_dz[_j]*t;
+}
+
+static void projectileScalar(const ProjectileParams &_p, const Streams &_s, size_t _count, size_t _runLength,
+														 size_t _runStride)
+{
+	for(size_t first=0, offset=0; first<_count; first+=_runLength, offset+=_runStride)
+	{
+		size_t n = _count-first < _runLength ? _count-first : _runLength;
+		for(size_t i=0; i<n; ++i)
+			projectileOne(_p,_s,offset+i);
+	}
+}
+
+static size_t findDeadScalar(const float *_py, size_t _count, size_t _runLength, size_t _runStride, float _floor,
+														 unsigned int *_dead)
+{
+	size_t numDead=0;
+	for(size_t first=0, offset=0; first<_count; first+=_runLength, offset+=_runStride)
+	{
+		size_t n = _count-first < _runLength ? _count-first : _runLength;
+		for(size_t i=0; i<n; ++i)
+		{
+			if(_py[offset+i] <= _floor)
+				_dead[numDead++]=static_cast<unsigned int>(first+i);
+		}
+	}
+	return numDead;
+}
+
+static void randomScalar(const uint32_t _key[2], const uint32_t _stream[2], uint64_t _counter, float *_out,
+												 size_t _numBlocks)
+{
+	for(size_t b=0; b<_numBlocks; ++b)
+	{
+		uint64_t counter=_counter+b;
+		uint32_t c[4]={static_cast<uint32_t>(counter),static_cast<uint32_t>(counter>>32),_stream[0],_stream[1]};
+		philox::block(c,_key[0],_key[1]);
+		for(int i=0; i<4; ++i)
+			_out[b*4+i]=philox::toFloat(c[i]);
+	}
+}
+
+#ifdef SIM_X86_DISPATCH
+//----------------------------------------------------------------------------------------------------------------------
+// SSE4, 4 particles at a time
+//----------------------------------------------------------------------------------------------------------------------
+__attribute__((target("sse4.1")))
+static void projectileSSE4(const ProjectileParams &_p, const Streams &_s, size_t _count, size_t _runLength,
+													 size_t _runStride)
+{
+	const __m128 wx=_mm_set1_ps(_p.m_wx);
+	const __m128 wy=_mm_set1_ps(_p.m_wy);
+	const __m128 wz=_mm_set1_ps(_p.m_wz);
+	const __m128 ox=_mm_set1_ps(_p.m_ox);
+	const __m128 oy=_mm_set1_ps(_p.m_oy);
+	const __m128 oz=_mm_set1_ps(_p.m_oz);
+	const __m128 gravity=_mm_set1_ps(_p.m_gravity);
+	const __m128 step=_mm_set1_ps(_p.m_step);
+	for(size_t first=0, offset=0; first<_count; first+=_runLength, offset+=_runStride)
+	{
+		size_t n = _count-first < _runLength ? _count-first : _runLength;
+		size_t i=0;
+		for(; i+4<=n; i+=4)
+		{
+			size_t j=offset+i;
+			__m128 t=_mm_add_ps(_mm_loadu_ps(_s.m_life+j),step);
+			_mm_storeu_ps(_s.m_life+j,t);
+			_mm_storeu_ps(_s.m_px+j,_mm_add_ps(ox,_mm_mul_ps(_mm_mul_ps(wx,_mm_loadu_ps(_s.m_dx+j)),t)));
+			__m128 y=_mm_add_ps(oy,_mm_mul_ps(_mm_mul_ps(wy,_mm_loadu_ps(_s.m_dy+j)),t));
+			_mm_storeu_ps(_s.m_py+j,_mm_add_ps(y,_mm_mul_ps(gravity,_mm_mul_ps(t,t))));
+			_mm_storeu_ps(_s.m_pz+j,_mm_add_ps(oz,_mm_mul_ps(_mm_mul_ps(wz,_mm_loadu_ps(_s.m_dz+j)),t)));
+		}
+		for(; i<n; ++i)
+			projectileOne(_p,_s,offset+i);
+	}
+}
+
+__attribute__((target("sse4.1,popcnt")))
+static size_t findDeadSSE4(const float *_py, size_t _count, size_t _runLength, size_t _runStride, float _floor,
+													 unsigned int *_dead)
+{
+	const __m128 floor=_mm_set1_ps(_floor);
+	size_t numDead=0;
+	for(size_t first=0, offset=0; first<_count; first+=_runLength, offset+=_runStride)
+	{
+		size_t n = _count-first < _runLength ? _count-first : _runLength;
+		size_t i=0;
+		for(; i+4<=n; i+=4)
+		{
+			unsigned int mask=_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(_py+offset+i),floor));
+			while(mask)
+			{
+				_dead[numDead++]=static_cast<unsigned int>(first+i+__builtin_ctz(mask));
+				mask&=mask-1;
+			}
+		}
+		for(; i<n; ++i)
+		{
+			if(_py[offset+i] <= _floor)
+				_dead[numDead++]=static_cast<unsigned int>(first+i);
+		}
+	}
+	return numDead;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// AVX2, 8 particles at a time
+//----------------------------------------------------------------------------------------------------------------------
+__attribute__((target("avx2")))
+static void projectileAVX2(const ProjectileParams &_p, const Streams &_s, size_t _count, size_t _runLength,
+													 size_t _runStride)
+{
+	const __m256 wx=_mm256_set1_ps(_p.m_wx);
+	const __m256 wy=_mm256_set1_ps(_p.m_wy);
+	const __m256 wz=_mm256_set1_ps(_p.m_wz);
+	const __m256 ox=_mm256_set1_ps(_p.m_ox);
+	const __m256 oy=_mm256_set1_ps(_p.m_oy);
+	const __m256 oz=_mm256_set1_ps(_p.m_oz);
+	const __m256 gravity=_mm256_set1_ps(_p.m_gravity);
+	const __m256 step=_mm256_set1_ps(_p.m_step);
+	for(size_t first=0, offset=0; first<_count; first+=_runLength, offset+=_runStride)
+	{
+		size_t n = _count-first < _runLength ? _count-first : _runLength;
+		size_t i=0;
+		for(; i+8<=n; i+=8)
+		{
+			size_t j=offset+i;
+			__m256 t=_mm256_add_ps(_mm256_loadu_ps(_s.m_life+j),step);
+			_mm256_storeu_ps(_s.m_life+j,t);
+			_mm256_storeu_ps(_s.m_px+j,_mm256_add_ps(ox,_mm256_mul_ps(_mm256_mul_ps(wx,_mm256_loadu_ps(_s.m_dx+j)),t)));
+			__m256 y=_mm256_add_ps(oy,_mm256_mul_ps(_mm256_mul_ps(wy,_mm256_loadu_ps(_s.m_dy+j)),t));
+			_mm256_storeu_ps(_s.m_py+j,_mm256_add_ps(y,_mm256_mul_ps(gravity,_mm256_mul_ps(t,t))));
+			_mm256_storeu_ps(_s.m_pz+j,_mm256_add_ps(oz,_mm256_mul_ps(_mm256_mul_ps(wz,_mm256_loadu_ps(_s.m_dz+j)),t)));
+		}
+		for(; i<n; ++i)
+			projectileOne(_p,_s,offset+i);
+	}
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t findDeadAVX2(const float *_py, size_t _count, size_t _runLength, size_t _runStride, float _floor,
+													 unsigned int *_dead)
+{
+	const __m256 floor=_mm256_set1_ps(_floor);
+	size_t numDead=0;
+	for(size_t first=0, offset=0; first<_count; first+=_runLength, offset+=_runStride)
+	{
+		size_t n = _count-first < _runLength ? _count-first : _runLength;
+		size_t i=0;
+		for(; i+8<=n; i+=8)
+		{
+			unsigned int mask=_mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(_py+offset+i),floor,_CMP_LE_OQ));
+			while(mask)
+			{
+				_dead[numDead++]=static_cast<unsigned int>(first+i+__builtin_ctz(mask));
+				mask&=mask-1;
+			}
+		}
+		for(; i<n; ++i)
+		{
+			if(_py[offset+i] <= _floor)
+				_dead[numDead++]=static_cast<unsigned int>(first+i);
+		}
+	}
+	return numDead;
+}
+
+/// @brief the 32 x 32 bit products of each lane of _a with _m as high and low halves
+__attribute__((target("avx2")))
+static inline void mulhilo(__m256i _a, __m256i _m, __m256i &o_hi, __m256i &o_lo)
+{
+	__m256i even=_mm256_mul_epu32(_a,_m);
+	__m256i odd=_mm256_mul_epu32(_mm256_srli_epi64(_a,32),_m);
+	o_lo=_mm256_blend_epi32(even,_mm256_slli_epi64(odd,32),0xAA);
+	o_hi=_mm256_blend_epi32(_mm256_srli_epi64(even,32),odd,0xAA);
+}
+
+/// @brief write 8 blocks held one word per register (_x0 has word 0 of each block) as 8 consecutive blocks of 4
+__attribute__((target("avx2")))
+static inline void store8Blocks(__m256 _x0, __m256 _x1, __m256 _x2, __m256 _x3, float *_out)
+{
+	__m256 t0=_mm256_unpacklo_ps(_x0,_x1);
+	__m256 t1=_mm256_unpackhi_ps(_x0,_x1);
+	__m256 t2=_mm256_unpacklo_ps(_x2,_x3);
+	__m256 t3=_mm256_unpackhi_ps(_x2,_x3);
+	// blocks 0|4, 1|5, 2|6 and 3|7
+	__m256 u0=_mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(t0),_mm256_castps_pd(t2)));
+	__m256 u1=_mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(t0),_mm256_castps_pd(t2)));
+	__m256 u2=_mm256_castpd_ps(_mm256_unpacklo_pd(_mm256_castps_pd(t1),_mm256_castps_pd(t3)));
+	__m256 u3=_mm256_castpd_ps(_mm256_unpackhi_pd(_mm256_castps_pd(t1),_mm256_castps_pd(t3)));
+	_mm256_storeu_ps(_out,_mm256_permute2f128_ps(u0,u1,0x20));
+	_mm256_storeu_ps(_out+8,_mm256_permute2f128_ps(u2,u3,0x20));
+	_mm256_storeu_ps(_out+16,_mm256_permute2f128_ps(u0,u1,0x31));
+	_mm256_storeu_ps(_out+24,_mm256_permute2f128_ps(u2,u3,0x31));
+}
+
+/// @brief the top 24 bits of each lane as a float in [0,1), the same as philox::toFloat
+__attribute__((target("avx2")))
+static inline __m256 toFloat(__m256i _x)
+{
+	return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(_x,8)),_mm256_set1_ps(philox::s_toFloat));
+}
+
+__attribute__((target("avx2")))
+static void randomAVX2(const uint32_t _key[2], const uint32_t _stream[2], uint64_t _counter, float *_out,
+											 size_t _numBlocks)
+{
+	const __m256i m0=_mm256_set1_epi32(static_cast<int>(philox::s_m0));
+	const __m256i m1=_mm256_set1_epi32(static_cast<int>(philox::s_m1));
+	size_t b=0;
+	for(; b+8<=_numBlocks; b+=8)
+	{
+		uint32_t lo[8];
+		uint32_t hi[8];
+		for(int l=0; l<8; ++l)
+		{
+			uint64_t counter=_counter+b+l;
+			lo[l]=static_cast<uint32_t>(counter);
+			hi[l]=static_cast<uint32_t>(counter>>32);
+		}
+		__m256i c0=_mm256_loadu_si256(reinterpret_cast<const __m256i *>(lo));
+		__m256i c1=_mm256_loadu_si256(reinterpret_cast<const __m256i *>(hi));
+		__m256i c2=_mm256_set1_epi32(static_cast<int>(_stream[0]));
+		__m256i c3=_mm256_set1_epi32(static_cast<int>(_stream[1]));
+		uint32_t k0=_key[0];
+		uint32_t k1=_key[1];
+		for(int r=0; r<philox::s_rounds; ++r)
+		{
+			__m256i hi0,lo0,hi1,lo1;
+			mulhilo(c0,m0,hi0,lo0);
+			mulhilo(c2,m1,hi1,lo1);
+			c0=_mm256_xor_si256(_mm256_xor_si256(hi1,c1),_mm256_set1_epi32(static_cast<int>(k0)));
+			c1=lo1;
+			c2=_mm256_xor_si256(_mm256_xor_si256(hi0,c3),_mm256_set1_epi32(static_cast<int>(k1)));
+			c3=lo0;
+			k0+=philox::s_w0;
+			k1+=philox::s_w1;
+		}
+		store8Blocks(toFloat(c0),toFloat(c1),toFloat(c2),toFloat(c3),_out+b*4);
+	}
+	randomScalar(_key,_stream,_counter+b,_out+b*4,_numBlocks-b);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// AVX-512, 16 particles at a time with the tail done under a mask
+//----------------------------------------------------------------------------------------------------------------------
+__attribute__((target("avx512f")))
+static void projectileAVX512(const ProjectileParams &_p, const Streams &_s, size_t _count, size_t _runLength,
+														 size_t _runStride)
+{
+	const __m512 wx=_mm512_set1_ps(_p.m_wx);
+	const __m512 wy=_mm512_set1_ps(_p.m_wy);
+	const __m512 wz=_mm512_set1_ps(_p.m_wz);
+	const __m512 ox=_mm512_set1_ps(_p.m_ox);
+	const __m512 oy=_mm512_set1_ps(_p.m_oy);
+	const __m512 oz=_mm512_set1_ps(_p.m_oz);
+	const __m512 gravity=_mm512_set1_ps(_p.m_gravity);
+	const __m512 step=_mm512_set1_ps(_p.m_step);
+	for(size_t first=0, offset=0; first<_count; first+=_runLength, offset+=_runStride)
+	{
+		size_t n = _count-first < _runLength ? _count-first : _runLength;
+		for(size_t i=0; i<n; i+=16)
+		{
+			size_t j=offset+i;
+			__mmask16 m = n-i>=16 ? 0xffff : static_cast<__mmask16>((1u<<(n-i))-1);
+			__m512 t=_mm512_add_ps(_mm512_maskz_loadu_ps(m,_s.m_life+j),step);
+			_mm512_mask_storeu_ps(_s.m_life+j,m,t);
+			_mm512_mask_storeu_ps(_s.m_px+j,m,_mm512_add_ps(ox,_mm512_mul_ps(_mm512_mul_ps(wx,_mm512_maskz_loadu_ps(m,_s.m_dx+j)),t)));
+			__m512 y=_mm512_add_ps(oy,_mm512_mul_ps(_mm512_mul_ps(wy,_mm512_maskz_loadu_ps(m,_s.m_dy+j)),t));
+			_mm512_mask_storeu_ps(_s.m_py+j,m,_mm512_add_ps(y,_mm512_mul_ps(gravity,_mm512_mul_ps(t,t))));
+			_mm512_mask_storeu_ps(_s.m_pz+j,m,_mm512_add_ps(oz,_mm512_mul_ps(_mm512_mul_ps(wz,_mm512_maskz_loadu_ps(m,_s.m_dz+j)),t)));
+		}
+	}
+}
+
+__attribute__((target("avx512f")))
+static size_t findDeadAVX512(const float *_py, size_t _count, size_t _runLength, size_t _runStride, float _floor,
+														 unsigned int *_dead)
+{
+	const __m512 floor=_mm512_set1_ps(_floor);
+	const __m512i lanes=_mm512_setr_epi32(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+	size_t numDead=0;
+	for(size_t first=0, offset=0; first<_count; first+=_runLength, offset+=_runStride)
+	{
+		size_t n = _count-first < _runLength ? _count-first : _runLength;
+		for(size_t i=0; i<n; i+=16)
+		{
+			__mmask16 m = n-i>=16 ? 0xffff : static_cast<__mmask16>((1u<<(n-i))-1);
+			__mmask16 dead=_mm512_mask_cmp_ps_mask(m,_mm512_maskz_loadu_ps(m,_py+offset+i),floor,_CMP_LE_OQ);
+			// write the lane indices of the dead particles packed together
+			__m512i index=_mm512_add_epi32(lanes,_mm512_set1_epi32(static_cast<int>(first+i)));
+			_mm512_mask_compressstoreu_epi32(_dead+numDead,dead,index);
+			numDead+=__builtin_popcount(dead);
+		}
+	}
+	return numDead;
+}
+
+__attribute__((target("avx512f")))
+static inline void mulhilo(__m512i _a, __m512i _m, __m512i &o_hi, __m512i &o_lo)
+{
+	__m512i even=_mm512_mul_epu32(_a,_m);
+	__m512i odd=_mm512_mul_epu32(_mm512_srli_epi64(_a,32),_m);
+	o_lo=_mm512_mask_blend_epi32(0xAAAA,even,_mm512_slli_epi64(odd,32));
+	o_hi=_mm512_mask_blend_epi32(0xAAAA,_mm512_srli_epi64(even,32),odd);
+}
+
+__attribute__((target("avx512f")))
+static void randomAVX512(const uint32_t _key[2], const uint32_t _stream[2], uint64_t _counter, float *_out,
+												 size_t _numBlocks)
+{
+	const __m512i m0=_mm512_set1_epi32(static_cast<int>(philox::s_m0));
+	const __m512i m1=_mm512_set1_epi32(static_cast<int>(philox::s_m1));
+	const __m512 scale=_mm512_set1_ps(philox::s_toFloat);
+	size_t b=0;
+	for(; b+16<=_numBlocks; b+=16)
+	{
+		uint32_t lo[16];
+		uint32_t hi[16];
+		for(int l=0; l<16; ++l)
+		{
+			uint64_t counter=_counter+b+l;
+			lo[l]=static_cast<uint32_t>(counter);
+			hi[l]=static_cast<uint32_t>(counter>>32);
+		}
+		__m512i c[4];
+		c[0]=_mm512_loadu_si512(lo);
+		c[1]=_mm512_loadu_si512(hi);
+		c[2]=_mm512_set1_epi32(static_cast<int>(_stream[0]));
+		c[3]=_mm512_set1_epi32(static_cast<int>(_stream[1]));
+		uint32_t k0=_key[0];
+		uint32_t k1=_key[1];
+		for(int r=0; r<philox::s_rounds; ++r)
+		{
+			__m512i hi0,lo0,hi1,lo1;
+			mulhilo(c[0],m0,hi0,lo0);
+			mulhilo(c[2],m1,hi1,lo1);
+			c[0]=_mm512_xor_si512(_mm512_xor_si512(hi1,c[1]),_mm512_set1_epi32(static_cast<int>(k0)));
+			c[1]=lo1;
+			c[2]=_mm512_xor_si512(_mm512_xor_si512(hi0,c[3]),_mm512_set1_epi32(static_cast<int>(k1)));
+			c[3]=lo0;
+			k0+=philox::s_w0;
+			k1+=philox::s_w1;
+		}
+		// convert then write the low 8 blocks and the high 8 with the AVX2 transpose
+		__m256 low[4];
+		__m256 high[4];
+		for(int w=0; w<4; ++w)
+		{
+			__m512 f=_mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(c[w],8)),scale);
+			low[w]=_mm512_castps512_ps256(f);
+			high[w]=_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(f),1));
+		}
+		store8Blocks(low[0],low[1],low[2],low[3],_out+b*4);
+		store8Blocks(high[0],high[1],high[2],high[3],_out+b*4+32);
+	}
+	randomScalar(_key,_stream,_counter+b,_out+b*4,_numBlocks-b);
+}
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+// dispatch
+//----------------------------------------------------------------------------------------------------------------------
+static const SimdKernels s_kernels[]=
+{
+	{SIMD_SCALAR,"scalar",projectileScalar,findDeadScalar,randomScalar},
+#ifdef SIM_X86_DISPATCH
+	// SSE4 has no 32 bit multiply high worth using so the generator stays scalar
+	{SIMD_SSE4,"sse4",projectileSSE4,findDeadSSE4,randomScalar},
+	{SIMD_AVX2,"avx2",projectileAVX2,findDeadAVX2,randomAVX2},
+	{SIMD_AVX512,"avx512",projectileAVX512,findDeadAVX512,randomAVX512}
+#endif
+};
+static const int s_numKernels=sizeof(s_kernels)/sizeof(SimdKernels);
+
+SimdLevel detectSimd()
+{
+#ifdef SIM_X86_DISPATCH
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f"))
+		return SIMD_AVX512;
+	if(__builtin_cpu_supports("avx2"))
+		return SIMD_AVX2;
+	if(__builtin_cpu_supports("sse4.1"))
+		return SIMD_SSE4;
+#endif
+	return SIMD_SCALAR;
+}
+
+const SimdKernels &simdKernels(SimdLevel _level)
+{
+	SimdLevel supported=detectSimd();
+	if(_level>supported)
+		_level=supported;
+	for(int i=s_numKernels-1; i>0; --i)
+	{
+		if(s_kernels[i].m_level<=_level)
+			return s_kernels[i];
+	}
+	return s_kernels[0];
+}
+
+static const SimdKernels &chooseKernels()
+{
+	SimdLevel level=detectSimd();
+	const char *force=getenv("SIM_SIMD");
+	if(force)
+	{
+		bool found=false;
+		for(int i=0; i<s_numKernels; ++i)
+		{
+			if(strcmp(force,s_kernels[i].m_name)==0)
+			{
+				level=s_kernels[i].m_level;
+				found=true;
+			}
+		}
+		if(!found)
+			std::cerr<<"SIM_SIMD="<<force<<" is not one of scalar, sse4, avx2 or avx512 (or isn't built in), ignoring it\n";
+	}
+	return simdKernels(level);
+}
+
+const SimdKernels &simdKernels()
+{
+	// a function static so the choice is made once, and safely if the first call is from several threads
+	static const SimdKernels &kernels=chooseKernels();
+	return kernels;
+}
+
+} // end namespace sim
@@ -0,0 +1,316 @@
+#include "sim/StreamingSystem.h"
+#include "sim/Aligned.h"
+#include "sim/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <stdint.h>
+#if defined(__SSE__) || defined(_M_X64)
+	#include <xmmintrin.h>
+	#define SIM_STREAM_STORES
+#endif
+
+namespace sim
+{
+
+/// @brief particles created per chunk in the ctor, 32k of FlatParticles so a chunk is a whole number of pages
+static const size_t s_spawnChunk=1024;
+
+StreamingSystem::StreamingSystem(const Vec3 &_pos, size_t _numParticles, float _step, bool _parallel,
+																 bool _deterministic, uint64_t _seed) :
+	m_pos(_pos), m_numParticles(_numParticles), m_wind(1,1,1), m_step(_step), m_frame(0), m_parallel(_parallel), m_seed(_seed),
+	m_respawns(0)
+{
+	unsigned int numThreads=ThreadPool::instance().numThreads();
+	m_streams.resize(numThreads);
+	for(unsigned int t=0; t<numThreads; ++t)
+		m_streams[t].m_random.reset(_seed,t);
+	// nothing is written here, the pages are first touched by the thread that fills them below which is the same
+	// share of the array that thread starts with in update() so on a NUMA machine they end up on its node
+	m_particles = static_cast<FlatParticle *>(alignedAlloc(_numParticles*sizeof(FlatParticle)));
+	if(_deterministic)
+		m_respawns = static_cast<uint32_t *>(alignedAlloc(_numParticles*sizeof(uint32_t)));
+	if(m_parallel)
+	{
+		ThreadPool::instance().parallelFor(0,_numParticles,s_spawnChunk,
+			[this](size_t _begin, size_t _end, unsigned int _thread)
+			{
+				spawnRange(_begin,_end,_thread);
+			});
+	}
+	else
+	{
+		for(size_t i=0; i<_numParticles; i+=s_spawnChunk)
+			spawnRange(i,std::min(i+s_spawnChunk,_numParticles),0);
+	}
+}
+
+StreamingSystem::~StreamingSystem()
+{
+	alignedFree(m_particles);
+	alignedFree(m_respawns);
+}
+
+void StreamingSystem::spawnRange(size_t _begin, size_t _end, unsigned int _thread)
+{
+	float randoms[3*s_spawnChunk];
+	size_t count=_end-_begin;
+	// one batch from this thread's own stream, nothing is shared between threads
+	if(!m_respawns)
+		m_streams[_thread].m_random.uniform(randoms,3*count);
+	for(size_t i=0; i<count; ++i)
+	{
+		FlatParticle &p=m_particles[_begin+i];
+		p.m_px=m_pos.m_x;
+		p.m_py=m_pos.m_y;
+		p.m_pz=m_pos.m_z;
+		p.m_currentLife=0.0f;
+		p.m_gravity=-9.0f;//4.65;
+		if(m_respawns)
+		{
+			m_respawns[_begin+i]=0;
+			spawnDeterministic(_begin+i);
+		}
+		else
+		{
+			// the same mapping as randomNumber / randomPositiveNumber
+			p.m_dx=(randoms[3*i]*2.0f-1.0f)*5.0f+0.5f;
+			p.m_dy=randoms[3*i+1]*10.0f+0.5f;
+			p.m_dz=(randoms[3*i+2]*2.0f-1.0f)*5.0f+0.5f;
+		}
+	}
+}
+
+void StreamingSystem::spawnDeterministic(size_t _i)
+{
+	float r[4];
+	RandomStream::uniformAt(m_seed,_i,m_respawns[_i],r);
+	// the same mapping as randomNumber / randomPositiveNumber
+	m_particles[_i].m_dx=(r[0]*2.0f-1.0f)*5.0f+0.5f;
+	m_particles[_i].m_dy=r[1]*10.0f+0.5f;
+	m_particles[_i].m_dz=(r[2]*2.0f-1.0f)*5.0f+0.5f;
+}
+
+void StreamingSystem::update(float *_out, size_t _stride)
+{
+	++m_frame;
+	if(!m_parallel)
+	{
+		updateRange(_out,_stride,0,m_numParticles,0);
+		return;
+	}
+	// a chunk's particles and its part of _out together fit in about an L1 cache
+	size_t chunkSize=ThreadPool::chunkSize(sizeof(FlatParticle)+_stride*sizeof(float));
+	ThreadPool::instance().parallelFor(0,m_numParticles,chunkSize,
+		[this,_out,_stride](size_t _begin, size_t _end, unsigned int _thread)
+		{
+			updateRange(_out,_stride,_begin,_end,_thread);
+		});
+}
+
+void StreamingSystem::updateRange(float *_out, size_t _stride, size_t _begin, size_t _end, unsigned int _thread)
+{
+	// each particle writes to its own slot in _out so the index comes from i rather than a shared counter, a chunk
+	// only ever touches its own part of the buffer
+	for(size_t i=_begin; i<_end; ++i)
+	{
+		size_t glIndex=i*_stride;
+		m_particles[i].m_currentLife+=m_step;
+		// use projectile motion equation to calculate the new position
+		// x(t)=Ix+Vxt
+		// y(t)=Iy+Vxt-1/2gt^2
+		// z(t)=Iz+Vzt
+
+		m_particles[i].m_px=m_pos.m_x+(m_wind.m_x*m_particles[i].m_dx*m_particles[i].m_currentLife);
+		m_particles[i].m_py= m_pos.m_y+(m_wind.m_y*m_particles[i].m_dy*m_particles[i].m_currentLife)+m_particles[i].m_gravity*(m_particles[i].m_currentLife*m_particles[i].m_currentLife);
+		m_particles[i].m_pz=m_pos.m_z+(m_wind.m_z*m_particles[i].m_dz*m_particles[i].m_currentLife);
+		_out[glIndex]=m_particles[i].m_px;
+		_out[glIndex+1]=m_particles[i].m_py;
+		_out[glIndex+2]=m_particles[i].m_pz;
+		// if we go below the origin re-set
+		if(m_particles[i].m_py <= m_pos.m_y-0.01f)
+		{
+			m_particles[i].m_px=m_pos.m_x;
+			m_particles[i].m_py=m_pos.m_y;
+			m_particles[i].m_pz=m_pos.m_z;
+
+			respawn(i,_thread);
+			_out[glIndex]=m_particles[i].m_px;
+			_out[glIndex+1]=m_particles[i].m_py;
+			_out[glIndex+2]=m_particles[i].m_pz;
+		}
+	}
+}
+
+void StreamingSystem::respawn(size_t _i, unsigned int _thread)
+{
+	m_particles[_i].m_currentLife=0.0f;
+	if(m_respawns)
+	{
+		++m_respawns[_i];
+		spawnDeterministic(_i);
+	}
+	else
+	{
+		// each thread draws from its own stream so there is nothing to lock
+		RandomStream *rand=&m_streams[_thread].m_random;
+		m_particles[_i].m_dx=rand->randomNumber(5)+0.5f;
+		m_particles[_i].m_dy=rand->randomPositiveNumber(10)+0.5f;
+		m_particles[_i].m_dz=rand->randomNumber(5)+0.5f;
+	}
+}
+
+void StreamingSystem::stream(float *_out)
+{
+	++m_frame;
+	if(!m_parallel)
+	{
+		streamRange(_out,0,m_numParticles,0);
+		return;
+	}
+	size_t chunkSize=ThreadPool::chunkSize(sizeof(FlatParticle)+3*sizeof(float));
+	ThreadPool::instance().parallelFor(0,m_numParticles,chunkSize,
+		[this,_out](size_t _begin, size_t _end, unsigned int _thread)
+		{
+			streamRange(_out,_begin,_end,_thread);
+		});
+}
+
+inline void StreamingSystem::streamParticle(size_t _i, float *o_pos, unsigned int _thread)
+{
+	FlatParticle &p=m_particles[_i];
+	p.m_currentLife+=m_step;
+	// the same sums in the same order as updateRange so the positions are bit identical
+	float px=m_pos.m_x+(m_wind.m_x*p.m_dx*p.m_currentLife);
+	float py=m_pos.m_y+(m_wind.m_y*p.m_dy*p.m_currentLife)+p.m_gravity*(p.m_currentLife*p.m_currentLife);
+	float pz=m_pos.m_z+(m_wind.m_z*p.m_dz*p.m_currentLife);
+	if(py <= m_pos.m_y-0.01f)
+	{
+		respawn(_i,_thread);
+		px=m_pos.m_x;
+		py=m_pos.m_y;
+		pz=m_pos.m_z;
+	}
+	// one write of the final value, nothing is kept in the particle
+	o_pos[0]=px;
+	o_pos[1]=py;
+	o_pos[2]=pz;
+}
+
+void StreamingSystem::streamRange(float *_out, size_t _begin, size_t _end, unsigned int _thread)
+{
+	size_t i=_begin;
+#ifdef SIM_STREAM_STORES
+	// 4 particles are 3 aligned vectors, build them on the stack and write them past the cache. Chunks start on a
+	// multiple of 16 particles so this is aligned whenever _out is
+	if((reinterpret_cast<uintptr_t>(_out+3*i)&15)==0)
+	{
+		float group[12];
+		for(; i+4<=_end; i+=4)
+		{
+			for(size_t j=0; j<4; ++j)
+				streamParticle(i+j,group+3*j,_thread);
+			_mm_stream_ps(_out+3*i,_mm_loadu_ps(group));
+			_mm_stream_ps(_out+3*i+4,_mm_loadu_ps(group+4));
+			_mm_stream_ps(_out+3*i+8,_mm_loadu_ps(group+8));
+		}
+	}
+#endif
+	for(; i<_end; ++i)
+		streamParticle(i,_out+3*i,_thread);
+#ifdef SIM_STREAM_STORES
+	// streaming stores are weakly ordered, make sure they are all out before the pool says the job is done
+	_mm_sfence();
+#endif
+}
+
+void StreamingSystem::writePositions(float *_out, size_t _stride) const
+{
+	if(!m_parallel)
+	{
+		writeRange(_out,_stride,0,m_numParticles);
+		return;
+	}
+	size_t chunkSize=ThreadPool::chunkSize(sizeof(FlatParticle)+_stride*sizeof(float));
+	ThreadPool::instance().parallelFor(0,m_numParticles,chunkSize,
+		[this,_out,_stride](size_t _begin, size_t _end, unsigned int)
+		{
+			writeRange(_out,_stride,_begin,_end);
+		});
+}
+
+void StreamingSystem::writeRange(float *_out, size_t _stride, size_t _begin, size_t _end) const
+{
+	// worked out from the life rather than read from m_px etc as stream() doesn't keep those
+	for(size_t i=_begin; i<_end; ++i)
+	{
+		const FlatParticle &p=m_particles[i];
+		_out[i*_stride]=m_pos.m_x+(m_wind.m_x*p.m_dx*p.m_currentLife);
+		_out[i*_stride+1]=m_pos.m_y+(m_wind.m_y*p.m_dy*p.m_currentLife)+p.m_gravity*(p.m_currentLife*p.m_currentLife);
+		_out[i*_stride+2]=m_pos.m_z+(m_wind.m_z*p.m_dz*p.m_currentLife);
+	}
+}
+
+void StreamingSystem::advance(GLSpawn *_spawns, unsigned int _frames)
+{
+	++m_frame;
+	if(!m_parallel)
+	{
+		advanceRange(_spawns,_frames,0,m_numParticles,0);
+		return;
+	}
+	// nothing is written for most particles so size the chunks on the particles alone
+	size_t chunkSize=ThreadPool::chunkSize(sizeof(FlatParticle));
+	ThreadPool::instance().parallelFor(0,m_numParticles,chunkSize,
+		[this,_spawns,_frames](size_t _begin, size_t _end, unsigned int _thread)
+		{
+			advanceRange(_spawns,_frames,_begin,_end,_thread);
+		});
+}
+
+void StreamingSystem::advanceRange(GLSpawn *_spawns, unsigned int _frames, size_t _begin, size_t _end,
+																	 unsigned int _thread)
+{
+	float frame=static_cast<float>(m_frame);
+	// a particle younger than this respawned in one of the updates _spawns missed, the life is a whole number of
+	// steps so half a step either way is plenty
+	float missed=(static_cast<float>(_frames)-0.5f)*m_step;
+	for(size_t i=_begin; i<_end; ++i)
+	{
+		FlatParticle &p=m_particles[i];
+		p.m_currentLife+=m_step;
+		// only the height is needed to know if it has landed, the same sum as streamParticle
+		float py=m_pos.m_y+(m_wind.m_y*p.m_dy*p.m_currentLife)+p.m_gravity*(p.m_currentLife*p.m_currentLife);
+		if(py <= m_pos.m_y-0.01f)
+		{
+			respawn(i,_thread);
+			_spawns[i].dx=p.m_dx;
+			_spawns[i].dy=p.m_dy;
+			_spawns[i].dz=p.m_dz;
+			_spawns[i].birth=frame;
+		}
+		else if(p.m_currentLife < missed)
+		{
+			// the same record the respawn wrote to the other copies, the birth worked back as writeSpawns does
+			_spawns[i].dx=p.m_dx;
+			_spawns[i].dy=p.m_dy;
+			_spawns[i].dz=p.m_dz;
+			_spawns[i].birth=frame-std::floor(p.m_currentLife/m_step+0.5f);
+		}
+	}
+}
+
+void StreamingSystem::writeSpawns(GLSpawn *_spawns) const
+{
+	float frame=static_cast<float>(m_frame);
+	for(size_t i=0; i<m_numParticles; ++i)
+	{
+		const FlatParticle &p=m_particles[i];
+		_spawns[i].dx=p.m_dx;
+		_spawns[i].dy=p.m_dy;
+		_spawns[i].dz=p.m_dz;
+		// the life is a whole number of steps, round off what adding them up has lost
+		_spawns[i].birth=frame-std::floor(p.m_currentLife/m_step+0.5f);
+	}
+}
+
+} // end namespace sim
@@ -0,0 +1,195 @@
+#include "sim/ThreadPool.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace sim
+{
+
+/// @brief the index of this thread in the pool, 0 for any thread that isn't a worker
+static thread_local unsigned int t_thread=0;
+/// @brief set while this thread is running part of a job so a nested parallelFor runs serially
+static thread_local bool t_inJob=false;
+
+ThreadPool &ThreadPool::instance()
+{
+	static ThreadPool pool(
+		[]()
+		{
+			const char *env=std::getenv("SIM_THREADS");
+			int n= env!=0 ? std::atoi(env) : static_cast<int>(std::thread::hardware_concurrency());
+			return static_cast<unsigned int>(std::max(n,1));
+		}());
+	return pool;
+}
+
+ThreadPool::ThreadPool(unsigned int _numThreads) :
+	m_numThreads(std::max(_numThreads,1u)), m_func(0), m_begin(0), m_end(0), m_chunkSize(1),
+	m_generation(0), m_busy(0), m_stop(false)
+{
+	m_queues = new Queue[m_numThreads];
+	for(unsigned int t=0; t<m_numThreads; ++t)
+	{
+		m_queues[t].m_first=0;
+		m_queues[t].m_last=0;
+	}
+	// thread 0 is whoever calls parallelFor
+	for(unsigned int t=1; t<m_numThreads; ++t)
+		m_workers.push_back(std::thread(&ThreadPool::worker,this,t));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop=true;
+	}
+	m_wake.notify_all();
+	for(size_t i=0; i<m_workers.size(); ++i)
+		m_workers[i].join();
+	delete [] m_queues;
+}
+
+size_t ThreadPool::chunkSize(size_t _bytesPerItem)
+{
+	size_t n=s_chunkBytes/std::max<size_t>(_bytesPerItem,1);
+	n&=~static_cast<size_t>(15);
+	return std::max<size_t>(n,16);
+}
+
+void ThreadPool::parallelFor(size_t _begin, size_t _end, size_t _chunkSize, const RangeFunction &_func)
+{
+	if(_end<=_begin)
+		return;
+	_chunkSize=std::max<size_t>(_chunkSize,1);
+	size_t numChunks=(_end-_begin+_chunkSize-1)/_chunkSize;
+	// already inside a job, our thread index is still unique so just do it here
+	if(t_inJob)
+	{
+		runSerial(_begin,_end,_chunkSize,_func,t_thread);
+		return;
+	}
+	std::lock_guard<std::mutex> submit(m_submit);
+	if(m_numThreads==1 || numChunks==1)
+	{
+		t_inJob=true;
+		runSerial(_begin,_end,_chunkSize,_func,0);
+		t_inJob=false;
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_func=&_func;
+		m_begin=_begin;
+		m_end=_end;
+		m_chunkSize=_chunkSize;
+		// an even contiguous share each, the first few get one extra
+		size_t share=numChunks/m_numThreads;
+		size_t extra=numChunks%m_numThreads;
+		size_t first=0;
+		for(unsigned int t=0; t<m_numThreads; ++t)
+		{
+			size_t count=share+(t<extra ? 1 : 0);
+			std::lock_guard<std::mutex> queueLock(m_queues[t].m_lock);
+			m_queues[t].m_first=first;
+			m_queues[t].m_last=first+count;
+			first+=count;
+		}
+		m_busy=m_numThreads-1;
+		++m_generation;
+	}
+	m_wake.notify_all();
+	t_inJob=true;
+	runChunks(0);
+	t_inJob=false;
+	// every chunk has been taken, wait for the workers to finish the ones they are running
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock,[this](){return m_busy==0;});
+	m_func=0;
+}
+
+void ThreadPool::runSerial(size_t _begin, size_t _end, size_t _chunkSize, const RangeFunction &_func,
+													 unsigned int _thread)
+{
+	// still a chunk at a time, the caller may rely on never getting more than _chunkSize
+	for(size_t begin=_begin; begin<_end; begin+=_chunkSize)
+		_func(begin,std::min(begin+_chunkSize,_end),_thread);
+}
+
+void ThreadPool::worker(unsigned int _thread)
+{
+	t_thread=_thread;
+	unsigned long seen=0;
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock,[this,seen](){return m_stop || m_generation!=seen;});
+			if(m_stop)
+				return;
+			seen=m_generation;
+		}
+		t_inJob=true;
+		runChunks(_thread);
+		t_inJob=false;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(--m_busy==0)
+			m_done.notify_one();
+	}
+}
+
+void ThreadPool::runChunks(unsigned int _thread)
+{
+	size_t chunk;
+	for(;;)
+	{
+		while(popChunk(_thread,chunk))
+			runChunk(chunk,_thread);
+		if(!steal(_thread))
+			return;
+	}
+}
+
+bool ThreadPool::popChunk(unsigned int _thread, size_t &_chunk)
+{
+	Queue &q=m_queues[_thread];
+	std::lock_guard<std::mutex> lock(q.m_lock);
+	if(q.m_first==q.m_last)
+		return false;
+	_chunk=q.m_first++;
+	return true;
+}
+
+bool ThreadPool::steal(unsigned int _thread)
+{
+	for(unsigned int i=1; i<m_numThreads; ++i)
+	{
+		Queue &victim=m_queues[(_thread+i)%m_numThreads];
+		size_t first;
+		size_t last;
+		{
+			std::lock_guard<std::mutex> lock(victim.m_lock);
+			size_t left=victim.m_last-victim.m_first;
+			if(left==0)
+				continue;
+			// take the back half, the victim keeps working forwards through the front
+			last=victim.m_last;
+			first=last-(left+1)/2;
+			victim.m_last=first;
+		}
+		Queue &q=m_queues[_thread];
+		std::lock_guard<std::mutex> lock(q.m_lock);
+		q.m_first=first;
+		q.m_last=last;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::runChunk(size_t _chunk, unsigned int _thread)
+{
+	size_t begin=m_begin+_chunk*m_chunkSize;
+	size_t end=std::min(begin+m_chunkSize,m_end);
+	(*m_func)(begin,end,_thread);
+}
+
+} // end namespace sim
@@ -0,0 +1,64 @@
+#include "sim/Vec3System.h"
+#include "sim/Random.h"
+
+namespace sim
+{
+
+Vec3System::Vec3System(const Vec3 &_pos, size_t _numParticles) : m_wind(1,1,1)
+{
+	Vec3Particle p;
+	Random *rand=Random::instance();
+	m_pos=_pos;
+
+	for (size_t i=0; i< _numParticles; ++i)
+	{
+		p.m_pos=_pos;
+		p.m_dir.m_x=rand->randomNumber(5)+0.5f;
+		p.m_dir.m_y=rand->randomPositiveNumber(10)+0.5f;
+		p.m_dir.m_z=rand->randomNumber(5)+0.5f;
+		p.m_currentLife=0.0f;
+		p.m_gravity=-9.0f;//4.65;
+
+		m_particles.push_back(p);
+	}
+	m_numParticles=_numParticles;
+}
+
+void Vec3System::update()
+{
+	for(size_t i=0; i<m_numParticles; ++i)
+	{
+		m_particles[i].m_currentLife+=0.05f;
+		// use projectile motion equation to calculate the new position
+		// x(t)=Ix+Vxt
+		// y(t)=Iy+Vxt-1/2gt^2
+		// z(t)=Iz+Vzt
+		m_particles[i].m_pos.m_x=m_pos.m_x+(m_wind.m_x*m_particles[i].m_dir.m_x*m_particles[i].m_currentLife);
+		m_particles[i].m_pos.m_y= m_pos.m_y+(m_wind.m_y*m_particles[i].m_dir.m_y*m_particles[i].m_currentLife)+m_particles[i].m_gravity*(m_particles[i].m_currentLife*m_particles[i].m_currentLife);
+		m_particles[i].m_pos.m_z=m_pos.m_z+(m_wind.m_z*m_particles[i].m_dir.m_z*m_particles[i].m_currentLife);
+
+		// if we go below the origin re-set
+		if(m_particles[i].m_pos.m_y <= m_pos.m_y-0.01f)
+		{
+			m_particles[i].m_pos=m_pos;
+			m_particles[i].m_currentLife=0.0f;
+			Random *rand=Random::instance();
+			m_particles[i].m_dir.m_x=rand->randomNumber(5)+0.5f;
+			m_particles[i].m_dir.m_y=rand->randomPositiveNumber(10)+0.5f;
+			m_particles[i].m_dir.m_z=rand->randomNumber(5)+0.5f;
+		}
+	}
+}
+
+void Vec3System::writePositions(float *_out, size_t _stride) const
+{
+	for(size_t i=0; i<m_numParticles; ++i)
+	{
+		const Vec3 &p=m_particles[i].m_pos;
+		_out[i*_stride]=p.m_x;
+		_out[i*_stride+1]=p.m_y;
+		_out[i*_stride+2]=p.m_z;
+	}
+}
+
+} // end namespace sim
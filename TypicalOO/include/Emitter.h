@@ -20,6 +20,10 @@ public :
 	void update();
 	/// @brief a method to draw all the particles contained in the system
 	void draw();
+	/// @brief switch between one instanced draw call and the original draw call per particle
+	inline void toggleInstanced(){m_instanced=!m_instanced;}
+	/// @brief dtor removes the instance buffer
+	~Emitter();
   inline void setCam(ngl::Camera *_cam){m_cam=_cam;}
   inline ngl::Camera * getCam()const {return m_cam;}
   inline void setShaderName(const std::string &_n){m_shaderName=_n;}
@@ -33,11 +37,19 @@ private :
 	std::vector <Particle> m_particles;
 	/// @brief a wind vector
 	ngl::Vec3 *m_wind;
+	/// @brief the copy of the wind the particles point at, refreshed each update
+	sim::Vec3 m_simWind;
   /// @brief the name of the shader to use
   std::string m_shaderName;
   /// @brief a pointer to the camera used for drawing
   ngl::Camera *m_cam;
   ngl::VertexArrayObject *m_vao;
+  /// @brief draw all the particles with one instanced call, on by default, M in the demo toggles it
+  bool m_instanced;
+  /// @brief the particle positions, one per instance, refilled each draw
+  GLuint m_instanceVBO;
+  /// @brief copy the positions into m_instanceVBO and draw them all with one call
+  void drawInstanced();
 
 };
 
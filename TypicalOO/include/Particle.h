@@ -4,34 +4,22 @@
 #include <ngl/Vec3.h>
 #include <ngl/Colour.h>
 #include <ngl/VertexArrayObject.h>
+#include <sim/ObjectParticle.h>
 
 class Emitter;
 
-class Particle
+/// @brief the update comes from sim::ObjectParticle, this adds the drawing
+class Particle : public sim::ObjectParticle
 {
 public :
 
 	/// @brief ctor
 	/// @param _pos the start position of the particle
-	Particle(ngl::Vec3 _pos,ngl::Vec3 *_wind, Emitter *_emitter, ngl::VertexArrayObject *vao	);
-	/// @brief a method to update the particle position
-	void update();
+	Particle(ngl::Vec3 _pos,const sim::Vec3 *_wind, Emitter *_emitter, ngl::VertexArrayObject *vao	);
 	/// @brief a method to draw the particle
 	void draw();
 
 private :
-	/// @brief the curent particle position
-	ngl::Vec3 m_pos;
-	/// @brief the original particle position
-	ngl::Vec3 m_origin;
-	/// @brief the direction vector of the particle
-	ngl::Vec3 m_dir;
-	/// @brief the current life value of the particle
-	float m_currentLife;
-	/// @brief gravity
-	GLfloat m_gravity;
-	/// @brief the wind vector
-	ngl::Vec3 *m_wind;
   /// @brief a pointer to our emitter
   const Emitter *m_emitter;
   ngl::VertexArrayObject *m_vao;
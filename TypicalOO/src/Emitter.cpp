@@ -19,12 +19,21 @@ Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind )
 	m_vao->setData(1*sizeof(ngl::Vec3),p.m_x);
 	m_vao->setVertexAttributePointer(0,3,GL_FLOAT,sizeof(ngl::Vec3),0);
 	m_vao->setNumIndices(1);
+	// the per particle positions for the instanced draw, attribute 1 steps once per instance rather than per vertex
+	glGenBuffers(1,&m_instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER,m_instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER,_numParticles*3*sizeof(GLfloat),0,GL_STREAM_DRAW);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1,3,GL_FLOAT,GL_FALSE,0,0);
+	glVertexAttribDivisor(1,1);
 	m_vao->unbind();
+	m_instanced=true;
 
 	m_wind=_wind;
+	m_simWind=sim::Vec3(m_wind->m_x,m_wind->m_y,m_wind->m_z);
 	for (int i=0; i< _numParticles; ++i)
 	{
-		m_particles.push_back(Particle(_pos,m_wind,this,m_vao));
+		m_particles.push_back(Particle(_pos,&m_simWind,this,m_vao));
 	}
 	m_numParticles=_numParticles;
 
@@ -35,6 +44,11 @@ Emitter::Emitter(ngl::Vec3 _pos, int _numParticles, ngl::Vec3 *_wind )
 	log->logMessage("Finished filling vector took %d milliseconds\n",timer.elapsed());
 
 }
+Emitter::~Emitter()
+{
+	glDeleteBuffers(1,&m_instanceVBO);
+}
+
 /// @brief a method to update each of the particles contained in the system
 void Emitter::update()
 {
@@ -42,6 +56,7 @@ void Emitter::update()
 	timer.start();
 	ngl::Logger *log = ngl::Logger::instance();
 	log->logMessage("Starting emitter update\n");
+	m_simWind=sim::Vec3(m_wind->m_x,m_wind->m_y,m_wind->m_z);
 
 	for(int i=0; i<m_numParticles; ++i)
 	{
@@ -57,6 +72,12 @@ void Emitter::draw()
 	timer.start();
 	ngl::Logger *log = ngl::Logger::instance();
 	log->logMessage("Starting emitter draw\n");
+	if(m_instanced)
+	{
+		drawInstanced();
+		log->logMessage("Finished instanced draw took %d milliseconds\n",timer.elapsed());
+		return;
+	}
 	m_vao->bind();
 	ngl::ShaderLib *shader=ngl::ShaderLib::instance();
 	shader->use("Point");
@@ -70,3 +91,27 @@ void Emitter::draw()
 	log->logMessage("Finished draw took %d milliseconds\n",timer.elapsed());
 
 }
+
+void Emitter::drawInstanced()
+{
+	// invalidated so the map doesn't wait on last frame's draw, see Drawing in the ParticleCore README
+	glBindBuffer(GL_ARRAY_BUFFER,m_instanceVBO);
+	GLfloat *data=static_cast<GLfloat *>(glMapBufferRange(GL_ARRAY_BUFFER,0,m_numParticles*3*sizeof(GLfloat),
+																												 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	if(data==0)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER,0);
+		return;
+	}
+	sim::writePositions(&m_particles[0],m_particles.size(),data,3);
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+	glBindBuffer(GL_ARRAY_BUFFER,0);
+
+	ngl::ShaderLib *shader=ngl::ShaderLib::instance();
+	shader->use("PointInstanced");
+	// the translation is in the instance data so this is the same for every particle and set once
+	shader->setRegisteredUniform("MVP",m_cam->getVPMatrix());
+	m_vao->bind();
+	glDrawArraysInstanced(GL_POINTS,0,1,m_numParticles);
+	m_vao->unbind();
+}